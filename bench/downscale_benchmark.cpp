@@ -0,0 +1,72 @@
+// Throughput of the thumbnail kernels in frames per second, halving full HD and 4K frames.
+// Built with -DSME_BUILD_BENCHMARKS=ON; it only needs the kernels, not Qt.
+
+#include "core/encoder/downscale.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+struct Picture
+{
+    const char* name;
+    std::size_t width;
+    std::size_t height;
+};
+
+template<typename Function>
+double framesPerSecond(std::size_t frames, Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < frames; i++)
+        function(i);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(frames) / elapsed.count();
+}
+}
+
+int main()
+{
+    // odd halves leave a few columns to the scalar tail of the vector kernels
+    const Picture pictures[] { { "1920x1080", 1920, 1080 }, { "3840x2160", 3840, 2160 }, { "1918x1078", 1918, 1078 } };
+    std::mt19937 random(42);
+
+    for (const Picture& picture : pictures)
+    {
+        const std::size_t sourceStride = picture.width * 4;
+        const std::size_t width = picture.width / 2;
+        const std::size_t height = picture.height / 2;
+        const std::size_t frames = 4'000'000'000 / (sourceStride * picture.height);
+
+        std::vector<std::uint8_t> source(sourceStride * picture.height);
+        for (auto& byte : source)
+            byte = static_cast<std::uint8_t>(random());
+
+        std::vector<std::uint8_t> expected(width * 4 * height);
+        Downscale::halveScalar(source.data(), sourceStride, expected.data(), width * 4, width, height);
+
+        for (const Downscale::Kernel& kernel : Downscale::kernels())
+        {
+            std::vector<std::uint8_t> halved(expected.size());
+            kernel.halve(source.data(), sourceStride, halved.data(), width * 4, width, height);
+
+            if (halved != expected)
+            {
+                std::printf("%s disagrees with the scalar kernel\n", kernel.name);
+                return 1;
+            }
+
+            const double fps = framesPerSecond(frames, [&](std::size_t)
+            {
+                kernel.halve(source.data(), sourceStride, halved.data(), width * 4, width, height);
+            });
+
+            std::printf("halve %-8s %-10s %10.0f fps\n", kernel.name, picture.name, fps);
+        }
+    }
+
+    return 0;
+}
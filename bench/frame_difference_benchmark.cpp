@@ -0,0 +1,77 @@
+// Throughput of the scene-cut kernels in frames per second, at the analysis size and at full HD.
+// Built with -DSME_BUILD_BENCHMARKS=ON; it only needs the kernels, not Qt.
+
+#include "core/encoder/frame_difference.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+struct Plane
+{
+    const char* name;
+    std::size_t width;
+    std::size_t height;
+};
+
+template<typename Function>
+double framesPerSecond(std::size_t frames, Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < frames; i++)
+        function(i);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(frames) / elapsed.count();
+}
+}
+
+int main()
+{
+    const Plane planes[] { { "160x90", 160, 90 }, { "1920x1080", 1920, 1080 } };
+    std::mt19937 random(42);
+
+    for (const Plane& plane : planes)
+    {
+        const std::size_t size = plane.width * plane.height;
+        const std::size_t frames = 2'000'000'000 / size;
+
+        // a few distinct frames, so that consecutive comparisons do not hit the same cache lines only
+        std::vector<std::vector<std::uint8_t>> pool(8, std::vector<std::uint8_t>(size));
+        for (auto& frame : pool)
+        {
+            for (auto& pixel : frame)
+                pixel = static_cast<std::uint8_t>(random());
+        }
+
+        const std::uint64_t expected = FrameDifference::sadScalar(pool[0].data(), pool[1].data(), size);
+        volatile std::uint64_t sink = 0;
+
+        for (const FrameDifference::Kernel& kernel : FrameDifference::kernels())
+        {
+            if (kernel.sad(pool[0].data(), pool[1].data(), size) != expected)
+            {
+                std::printf("%s disagrees with the scalar kernel\n", kernel.name);
+                return 1;
+            }
+
+            const double fps = framesPerSecond(frames, [&](std::size_t i)
+            {
+                sink = sink + kernel.sad(pool[i % pool.size()].data(), pool[(i + 1) % pool.size()].data(), size);
+            });
+
+            std::printf("sad %-8s %-10s %12.0f fps\n", kernel.name, plane.name, fps);
+        }
+
+        const double fps = framesPerSecond(frames / 4, [&](std::size_t i)
+        {
+            sink = sink + FrameDifference::histogram(pool[i % pool.size()].data(), size)[0];
+        });
+
+        std::printf("histogram         %-10s %12.0f fps\n", plane.name, fps);
+    }
+
+    return 0;
+}
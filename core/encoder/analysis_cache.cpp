@@ -0,0 +1,49 @@
+#include "analysis_cache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <utility>
+
+AnalysisCache::AnalysisCache(std::shared_ptr<Settings> history)
+    : history(std::move(history))
+{
+}
+
+QString AnalysisCache::identityOf(const QString& path)
+{
+    const QFileInfo file(path);
+    const QString identity = QStringList {
+        file.canonicalFilePath(),
+        QString::number(file.size()),
+        QString::number(file.lastModified().toMSecsSinceEpoch()),
+    }.join('|');
+
+    // paths make poor ini keys, so they are hashed into something short and plain
+    return QCryptographicHash::hash(identity.toUtf8(), QCryptographicHash::Sha1).toHex().left(20);
+}
+
+QVariant AnalysisCache::get(const QString& analysis, const QString& path) const
+{
+    return history->get(keyFor(analysis, path));
+}
+
+void AnalysisCache::Set(const QString& analysis, const QString& path, const QVariant& value)
+{
+    history->Set(keyFor(analysis, path), value);
+}
+
+QString AnalysisCache::filePathFor(const QString& analysis, const QString& path) const
+{
+    const QDir directory(QFileInfo(history->fileName()).absoluteDir().filePath("analysis/" + analysis));
+    directory.mkpath(".");
+
+    return directory.filePath(identityOf(path));
+}
+
+QString AnalysisCache::keyFor(const QString& analysis, const QString& path)
+{
+    return "Analysis." + analysis + "/" + identityOf(path);
+}
@@ -0,0 +1,36 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include "core/settings/settings.hpp"
+
+#include <QString>
+#include <QVariant>
+#include <di.hpp>
+#include <memory>
+
+//!
+//! \brief Remembers what analysis passes found out about input files.
+//! \details Analysis passes decode the whole input, which can take as long as the encode itself, so their results are
+//! persisted per file and kind of analysis. Files are identified by their path, size and modification time, which
+//! tells an edited file apart without reading any of it.
+//!
+class AnalysisCache
+{
+public:
+    BOOST_DI_INJECT(AnalysisCache, (named = di_history) std::shared_ptr<Settings> history);
+
+    [[nodiscard]] static QString identityOf(const QString& path);
+
+    //! Invalid when the file was never analyzed this way, or has changed since.
+    [[nodiscard]] QVariant get(const QString& analysis, const QString& path) const;
+    void Set(const QString& analysis, const QString& path, const QVariant& value);
+    //! Where to store a result too large for the settings, in a directory next to them that is created on demand.
+    [[nodiscard]] QString filePathFor(const QString& analysis, const QString& path) const;
+
+private:
+    [[nodiscard]] static QString keyFor(const QString& analysis, const QString& path);
+
+    std::shared_ptr<Settings> history;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "animated_image.hpp"
+
+#include <cmath>
+
+bool AnimatedImagePlanner::isAnimatedImage(const Codec& codec)
+{
+    return codec.libraryName == "gif" || codec.libraryName == "libwebp_anim";
+}
+
+AnimatedImagePlanner::Geometry AnimatedImagePlanner::geometryFor(const EncoderOptions& options, const Metadata& metadata, double pixelRateScale) const
+{
+    const double scale = qBound(minScale, pixelRateScale, 1.0);
+    const double sourceFps = metadata.frameRate * options.speed.value_or(1);
+    const bool hasFixedSize = options.outputWidth.has_value() || options.outputHeight.has_value();
+
+    Geometry geometry;
+    double areaScale = scale;
+
+    if (!options.fps.has_value() && sourceFps > 0)
+    {
+        const double topFps = qMin(sourceFps, maxFps(*options.videoCodec));
+
+        // the frame rate takes a third of the reduction, or all of it when the size is fixed
+        const double fpsScale = hasFixedSize ? scale : std::cbrt(scale);
+        const double fps = qMax(qMin(minFps, topFps), std::round(topFps * fpsScale));
+
+        geometry.fps = fps;
+        areaScale = scale * topFps / fps;
+    }
+
+    if (!hasFixedSize && metadata.width > 0 && metadata.height > 0)
+    {
+        // square pixels, since neither format stores an aspect ratio
+        const double displayWidth = metadata.height * metadata.aspectRatioX / metadata.aspectRatioY;
+        const double sideScale = std::sqrt(qMin(1.0, areaScale));
+
+        geometry.width = qMax(2, qRound(displayWidth * sideScale / 2) * 2);
+        geometry.height = qMax(2, qRound(metadata.height * sideScale / 2) * 2);
+    }
+
+    return geometry;
+}
+
+double AnimatedImagePlanner::initialScale(const EncoderOptions& options, const Metadata& metadata) const
+{
+    const Geometry full = geometryFor(options, metadata, 1);
+
+    const double width = full.width.value_or(options.outputWidth.value_or(metadata.width));
+    const double height = full.height.value_or(options.outputHeight.value_or(metadata.height));
+    const double fps = full.fps.value_or(options.fps.value_or(metadata.frameRate));
+    const double fullKbps = bitsPerPixel(*options.videoCodec) * width * height * fps / 1000;
+
+    if (!options.sizeKbps.has_value() || fullKbps <= 0 || metadata.durationSeconds <= 0)
+        return 1;
+
+    return qBound(minScale, *options.sizeKbps / metadata.durationSeconds / fullKbps, 1.0);
+}
+
+bool AnimatedImagePlanner::isScalable(const EncoderOptions& options) const
+{
+    const bool hasFixedSize = options.outputWidth.has_value() || options.outputHeight.has_value();
+    return !hasFixedSize || !options.fps.has_value();
+}
+
+QString AnimatedImagePlanner::outputFilters(const Codec& codec) const
+{
+    // a palette made for this very clip beats the generic 256 colors, and diff stats favor the parts that move
+    if (codec.libraryName == "gif")
+        return "split[frames][paletteFrames];[paletteFrames]palettegen=stats_mode=diff[palette];"
+               "[frames][palette]paletteuse=dither=bayer:bayer_scale=5:diff_mode=rectangle[out]";
+
+    return "null[out]";
+}
+
+QString AnimatedImagePlanner::codecParams(const Codec& codec) const
+{
+    if (codec.libraryName == "libwebp_anim")
+        return "-loop 0";
+
+    return "";
+}
+
+double AnimatedImagePlanner::bufferedFramesMb(const EncoderOptions& options, const Metadata& metadata, const Geometry& geometry) const
+{
+    if (options.videoCodec->libraryName != "gif")
+        return 0;
+
+    const double width = geometry.width.value_or(options.outputWidth.value_or(metadata.width));
+    const double height = geometry.height.value_or(options.outputHeight.value_or(metadata.height));
+    const double fps = geometry.fps.value_or(options.fps.value_or(metadata.frameRate));
+
+    // rgb24 frames
+    return width * height * 3 * fps * metadata.durationSeconds / (1024 * 1024);
+}
+
+double AnimatedImagePlanner::maxFps(const Codec& codec) const
+{
+    // GIF delays are in hundredths of a second and browsers slow down anything under 2
+    return codec.libraryName == "gif" ? 25 : 30;
+}
+
+double AnimatedImagePlanner::bitsPerPixel(const Codec& codec) const
+{
+    return codec.libraryName == "gif" ? 0.8 : 0.15;
+}
@@ -0,0 +1,52 @@
+#ifndef ANIMATED_IMAGE_H
+#define ANIMATED_IMAGE_H
+
+#include "core/formats/codec.hpp"
+#include "encoder_options.hpp"
+
+#include <QString>
+
+//!
+//! \brief Plans GIF and animated WebP exports.
+//! \details Animated images have no bitrate control, so their size is steered through the frame rate and the
+//! dimensions instead. Both are derived from a single scale applied to the pixel rate (width x height x fps), which
+//! the encoder searches for by running trial encodes until the output fits the desired size.
+//!
+class AnimatedImagePlanner
+{
+public:
+    struct Geometry
+    {
+        optional<int> width;
+        optional<int> height;
+        optional<double> fps;
+    };
+
+    [[nodiscard]] static bool isAnimatedImage(const Codec& codec);
+
+    //! Frame rate and dimensions at a fraction of the largest pixel rate; whatever the user set is left alone. The
+    //! metadata is the one planned for, i.e. that of the trimmed input.
+    [[nodiscard]] Geometry geometryFor(const EncoderOptions& options, const Metadata& metadata, double pixelRateScale) const;
+    //! First guess at the scale that fits the desired size, from a rough bits per pixel figure.
+    [[nodiscard]] double initialScale(const EncoderOptions& options, const Metadata& metadata) const;
+    //! Whether the scale changes anything, i.e. the frame rate or the dimensions are on auto.
+    [[nodiscard]] bool isScalable(const EncoderOptions& options) const;
+
+    //! Filters appended to the video filters, ending on the [out] pad.
+    [[nodiscard]] QString outputFilters(const Codec& codec) const;
+    [[nodiscard]] QString codecParams(const Codec& codec) const;
+    //! paletteuse holds every frame until palettegen has seen the whole input.
+    [[nodiscard]] double bufferedFramesMb(const EncoderOptions& options, const Metadata& metadata, const Geometry& geometry) const;
+
+    const int trialsPerRound = 3;
+    const int rounds = 3;
+    const double minScale = 0.005;
+
+private:
+    [[nodiscard]] double maxFps(const Codec& codec) const;
+    [[nodiscard]] double bitsPerPixel(const Codec& codec) const;
+
+    const double minFps = 6;
+};
+
+#endif
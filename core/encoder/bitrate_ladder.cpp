@@ -0,0 +1,93 @@
+#include "bitrate_ladder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// > 0 when o, a, b turn left, with bitrates on a logarithmic scale as quality grows roughly with its logarithm
+double cross(const BitrateLadder::Probe& o, const BitrateLadder::Probe& a, const BitrateLadder::Probe& b)
+{
+    const double ax = std::log(a.bitrateKbps) - std::log(o.bitrateKbps);
+    const double bx = std::log(b.bitrateKbps) - std::log(o.bitrateKbps);
+
+    return ax * (b.qualityDb - o.qualityDb) - (a.qualityDb - o.qualityDb) * bx;
+}
+}
+
+QList<BitrateLadder::Probe> BitrateLadder::probesFor(const Metadata& metadata) const
+{
+    if (metadata.width <= 0 || metadata.height <= 0)
+        return {};
+
+    const double displayAspectRatio = metadata.aspectRatioX / metadata.aspectRatioY;
+    const double frameRate = metadata.frameRate > 0 ? qMin(metadata.frameRate, 60.0) : 30;
+
+    QList<int> probedHeights { static_cast<int>(metadata.height) };
+    for (const int height : heights)
+    {
+        if (height < metadata.height && probedHeights.size() < maxProbedHeights)
+            probedHeights.append(height);
+    }
+
+    QList<Probe> probes;
+    for (const int height : probedHeights)
+    {
+        const int width = qRound(height * displayAspectRatio / 2) * 2;
+
+        for (const double bits : bitsPerPixel)
+            probes.append({ .width = width, .height = height, .bitrateKbps = qMax(1.0, std::round(bits * width * height * frameRate / 1000)) });
+    }
+
+    return probes;
+}
+
+QList<BitrateLadder::Probe> BitrateLadder::convexHull(QList<Probe> probes) const
+{
+    std::sort(probes.begin(), probes.end(), [](const Probe& a, const Probe& b)
+    {
+        return a.bitrateKbps < b.bitrateKbps || (a.bitrateKbps == b.bitrateKbps && a.qualityDb > b.qualityDb);
+    });
+
+    QList<Probe> hull;
+    for (const Probe& probe : probes)
+    {
+        // only the best probe at any given bitrate can be on the hull
+        if (!hull.isEmpty() && hull.last().bitrateKbps == probe.bitrateKbps)
+            continue;
+
+        while (hull.size() >= 2 && cross(hull[hull.size() - 2], hull.last(), probe) >= 0)
+            hull.removeLast();
+
+        hull.append(probe);
+    }
+
+    // past the best quality, spending more bits only makes things worse
+    const auto best = std::max_element(hull.begin(), hull.end(), [](const Probe& a, const Probe& b)
+    {
+        return a.qualityDb < b.qualityDb;
+    });
+
+    if (best != hull.end())
+        hull.erase(best + 1, hull.end());
+
+    return hull;
+}
+
+QList<BitrateLadder::Probe> BitrateLadder::rungs(const QList<Probe>& hull) const
+{
+    QList<Probe> rungs;
+
+    for (auto it = hull.rbegin(); it != hull.rend() && rungs.size() < maxRungs; ++it)
+    {
+        if (rungs.isEmpty() || it->bitrateKbps * minRungStep <= rungs.last().bitrateKbps)
+            rungs.append(*it);
+    }
+
+    return rungs;
+}
+
+double BitrateLadder::ssimToDecibels(double ssim)
+{
+    return ssim >= 1 ? 100 : -10 * std::log10(1 - ssim);
+}
@@ -0,0 +1,41 @@
+#ifndef BITRATE_LADDER_H
+#define BITRATE_LADDER_H
+
+#include "core/formats/metadata.hpp"
+
+#include <QList>
+
+//!
+//! \brief Chooses the rungs of a per-title bitrate ladder from probe encodes of the input.
+//! \details Short excerpts are encoded at a grid of resolutions and bitrates, and each probe is scored against the
+//! source. Only probes on the upper convex hull of quality over bitrate are worth serving, since any other one is
+//! beaten by a mix of its neighbours on the hull. The rungs are then picked from the hull, spaced apart in bitrate.
+//!
+class BitrateLadder
+{
+public:
+    struct Probe
+    {
+        int width;
+        int height;
+        double bitrateKbps;
+        double qualityDb = 0; // SSIM in decibels
+    };
+
+    [[nodiscard]] QList<Probe> probesFor(const Metadata& metadata) const;
+    [[nodiscard]] QList<Probe> convexHull(QList<Probe> probes) const;
+    [[nodiscard]] QList<Probe> rungs(const QList<Probe>& hull) const;
+
+    [[nodiscard]] static double ssimToDecibels(double ssim);
+
+    const double excerptSeconds = 10;
+
+private:
+    const QList<int> heights { 2160, 1440, 1080, 720, 540, 360, 240 };
+    const QList<double> bitsPerPixel { 0.02, 0.04, 0.08, 0.16 };
+    const int maxProbedHeights = 4;
+    const int maxRungs = 4;
+    const double minRungStep = 1.5; // bitrate ratio between neighbouring rungs
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "crop_detector.hpp"
+
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+
+namespace
+{
+// cropdetect rounds to even values and flickers by a few pixels on noisy edges
+constexpr int edgeTolerance = 8;
+// bars thinner than this are not worth a filter
+constexpr double minCroppedFraction = 0.02;
+
+bool isAlike(const QRect& a, const QRect& b)
+{
+    return qAbs(a.left() - b.left()) <= edgeTolerance && qAbs(a.top() - b.top()) <= edgeTolerance
+        && qAbs(a.right() - b.right()) <= edgeTolerance && qAbs(a.bottom() - b.bottom()) <= edgeTolerance;
+}
+}
+
+CropDetector::CropDetector(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<optional<QRect>> CropDetector::Detect(const QString& inputPath, const Metadata& metadata, bool isInteractive)
+{
+    const QVariant cached = cache.get(analysis, inputPath);
+    if (cached.isValid())
+    {
+        const QRect crop = cached.toRect();
+        return QtFuture::makeReadyValueFuture(crop.isValid() ? optional(crop) : optional<QRect>());
+    }
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (pending.contains(identity))
+    {
+        if (isInteractive)
+        {
+            for (QProcess* process : pending[identity]->processes)
+                scheduler.Prioritize(process);
+        }
+
+        return pending[identity]->promise.future();
+    }
+
+    const auto detection = QSharedPointer<Detection>::create();
+    detection->identity = identity;
+    detection->inputPath = inputPath;
+    detection->frame = QSize(qRound(metadata.width), qRound(metadata.height));
+    detection->isInteractive = isInteractive;
+    detection->promise.start();
+
+    if (detection->frame.isEmpty())
+    {
+        detection->promise.addResult(optional<QRect>());
+        detection->promise.finish();
+        return detection->promise.future();
+    }
+
+    pending.insert(identity, detection);
+
+    // a short input is analyzed whole
+    const double spanSeconds = metadata.durationSeconds * (1 - 2 * skippedFraction);
+    const int samples = spanSeconds > sampleSeconds * sampleCount ? sampleCount : 1;
+    detection->remaining = samples;
+
+    for (int i = 0; i < samples; i++)
+    {
+        if (samples == 1)
+            StartSample(detection, metadata, 0, metadata.durationSeconds);
+        else
+            StartSample(detection, metadata, metadata.durationSeconds * skippedFraction + spanSeconds * (i + 0.5) / samples, sampleSeconds);
+    }
+
+    return detection->promise.future();
+}
+
+optional<QRect> CropDetector::settle(const QList<QRect>& samples, const QSize& frame)
+{
+    const QRect picture(QPoint(0, 0), frame);
+
+    QRect bounds;
+    QList<QRect> valid;
+    for (const QRect& sample : samples)
+    {
+        if (sample.isValid() && picture.contains(sample))
+        {
+            valid.append(sample);
+            bounds = bounds.united(sample);
+        }
+    }
+
+    // dark scenes shrink their own sample, but the bars stay put in all the others
+    const auto agreeing = std::count_if(valid.begin(), valid.end(), [&bounds](const QRect& sample) { return isAlike(sample, bounds); });
+    if (valid.isEmpty() || agreeing * 2 < valid.size())
+        return {};
+
+    const bool isWorthCropping = bounds.width() < frame.width() * (1 - minCroppedFraction) || bounds.height() < frame.height() * (1 - minCroppedFraction);
+    return isWorthCropping ? optional(bounds) : optional<QRect>();
+}
+
+void CropDetector::StartSample(const QSharedPointer<Detection>& detection, const Metadata& metadata, double startSeconds, double durationSeconds)
+{
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -ss %1 -i "%2" -t %3 -map 0:v:0 -vf cropdetect=limit=24:round=2:reset=0 -an -f null -)")
+                                .arg(QString::number(startSeconds), detection->inputPath, QString::number(durationSeconds));
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(metadata, {}), .isInteractive = detection->isInteractive });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+    detection->processes.append(ffmpeg);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndSample(detection);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        // with reset=0 the last line covers everything the sample has shown
+        static const QRegularExpression regex(R"(crop=(\d+):(\d+):(\d+):(\d+))");
+        QRegularExpressionMatch last;
+        for (const QRegularExpressionMatch& match : regex.globalMatch(QString(ffmpeg->readAll())))
+            last = match;
+
+        if (exitCode == 0 && last.hasMatch())
+            detection->samples.append(QRect(last.captured(3).toInt(), last.captured(4).toInt(), last.captured(1).toInt(), last.captured(2).toInt()));
+
+        EndSample(detection);
+    });
+}
+
+void CropDetector::EndSample(const QSharedPointer<Detection>& detection)
+{
+    if (--detection->remaining > 0)
+        return;
+
+    pending.remove(detection->identity);
+
+    const optional<QRect> crop = settle(detection->samples, detection->frame);
+
+    // a failed analysis is worth retrying next time, an input without bars is not
+    if (!detection->samples.isEmpty())
+        cache.Set(analysis, detection->inputPath, crop.value_or(QRect()));
+
+    detection->promise.addResult(crop);
+    detection->promise.finish();
+}
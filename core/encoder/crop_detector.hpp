@@ -0,0 +1,69 @@
+#ifndef CROP_DETECTOR_H
+#define CROP_DETECTOR_H
+
+#include "core/formats/metadata.hpp"
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QPromise>
+#include <QRect>
+#include <QSharedPointer>
+#include <QSize>
+#include <QString>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Finds the black bars of letterboxed and pillarboxed inputs with FFmpeg's cropdetect filter.
+//! \details Short stretches spread over the input are analyzed concurrently. A single dark scene looks like a smaller
+//! picture, so the samples are combined into the rectangle that contains all of them, and that rectangle is only kept
+//! when enough samples agree on it. Results are cached per file.
+//!
+class CropDetector final : public QObject
+{
+public:
+    explicit CropDetector(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves to nothing when there are no bars worth cropping, or when they could not be told apart from the picture.
+    //! An interactive detection runs ahead of anything queued, along with one of the same file that is already pending.
+    QFuture<optional<QRect>> Detect(const QString& inputPath, const Metadata& metadata, bool isInteractive = false);
+
+    [[nodiscard]] static optional<QRect> settle(const QList<QRect>& samples, const QSize& frame);
+
+private:
+    struct Detection
+    {
+        QString identity;
+        QString inputPath;
+        QSize frame;
+        QList<QRect> samples;
+        QList<QPointer<QProcess>> processes;
+        bool isInteractive = false;
+        int remaining = 0;
+        QPromise<optional<QRect>> promise;
+    };
+
+    void StartSample(const QSharedPointer<Detection>& detection, const Metadata& metadata, double startSeconds, double durationSeconds);
+    void EndSample(const QSharedPointer<Detection>& detection);
+
+    const QString analysis = "Crop";
+    const int sampleCount = 8;
+    const double sampleSeconds = 2;
+    // edges of the intros and credits, which are often black or framed differently
+    const double skippedFraction = 0.05;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, QSharedPointer<Detection>> pending;
+};
+
+#endif
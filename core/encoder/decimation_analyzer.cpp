@@ -0,0 +1,112 @@
+#include "decimation_analyzer.hpp"
+
+#include <QProcess>
+#include <QRegularExpression>
+
+DecimationAnalyzer::DecimationAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<double> DecimationAnalyzer::Measure(const QString& inputPath, const Metadata& metadata, bool isInteractive)
+{
+    const QVariant cached = cache.get(analysis, inputPath);
+    if (cached.isValid())
+        return QtFuture::makeReadyValueFuture(cached.toDouble());
+
+    if (metadata.frameRate <= 0 || metadata.durationSeconds <= 0)
+        return QtFuture::makeReadyValueFuture(1.0);
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (pending.contains(identity))
+    {
+        if (isInteractive)
+        {
+            for (QProcess* process : pending[identity]->processes)
+                scheduler.Prioritize(process);
+        }
+
+        return pending[identity]->promise.future();
+    }
+
+    const auto measurement = QSharedPointer<Measurement>::create();
+    measurement->identity = identity;
+    measurement->inputPath = inputPath;
+    measurement->isInteractive = isInteractive;
+    measurement->promise.start();
+    pending.insert(identity, measurement);
+
+    // a short input is decimated whole
+    const int samples = metadata.durationSeconds > sampleSeconds * sampleCount * 2 ? sampleCount : 1;
+    measurement->remaining = samples;
+
+    for (int i = 0; i < samples; i++)
+    {
+        if (samples == 1)
+            StartSample(measurement, metadata, 0, metadata.durationSeconds);
+        else
+            StartSample(measurement, metadata, metadata.durationSeconds * (i + 0.5) / samples, sampleSeconds);
+    }
+
+    return measurement->promise.future();
+}
+
+int DecimationAnalyzer::maxDroppedFrames(double frameRate) const
+{
+    // a rate that is not known would otherwise keep every other frame
+    return qMax(1, qRound((frameRate > 0 ? frameRate : nominalFrameRate) * maxDroppedSeconds));
+}
+
+void DecimationAnalyzer::StartSample(const QSharedPointer<Measurement>& measurement, const Metadata& metadata, double startSeconds, double seconds)
+{
+    const QString command = QString(R"(ffmpeg -hide_banner -ss %1 -i "%2" -t %3 -map 0:v:0 -vf mpdecimate=max=%4 -fps_mode vfr -an -f null -)")
+                                .arg(QString::number(startSeconds), measurement->inputPath, QString::number(seconds))
+                                .arg(maxDroppedFrames(metadata.frameRate));
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(metadata, {}), .isInteractive = measurement->isInteractive });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+    measurement->processes.append(ffmpeg);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndSample(measurement);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        // the last progress line counts the frames that made it through the filter
+        static const QRegularExpression regex(R"(frame=\s*(\d+))");
+        QRegularExpressionMatch last;
+        for (const QRegularExpressionMatch& match : regex.globalMatch(QString(ffmpeg->readAll())))
+            last = match;
+
+        if (exitCode == 0 && last.hasMatch())
+        {
+            measurement->keptFrames += last.captured(1).toDouble();
+            measurement->expectedFrames += seconds * metadata.frameRate;
+        }
+
+        EndSample(measurement);
+    });
+}
+
+void DecimationAnalyzer::EndSample(const QSharedPointer<Measurement>& measurement)
+{
+    if (--measurement->remaining > 0)
+        return;
+
+    pending.remove(measurement->identity);
+
+    double keptFraction = 1;
+    if (measurement->expectedFrames > 0)
+    {
+        keptFraction = qBound(minKeptFraction, measurement->keptFrames / measurement->expectedFrames, 1.0);
+        cache.Set(analysis, measurement->inputPath, keptFraction);
+    }
+
+    measurement->promise.addResult(keptFraction);
+    measurement->promise.finish();
+}
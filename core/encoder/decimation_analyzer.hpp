@@ -0,0 +1,66 @@
+#ifndef DECIMATION_ANALYZER_H
+#define DECIMATION_ANALYZER_H
+
+#include "core/formats/metadata.hpp"
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+
+//!
+//! \brief Estimates how many frames of an input are left once duplicates are dropped with FFmpeg's mpdecimate filter.
+//! \details Screen recordings often repeat the same frame for seconds on end. Dropping those frames leaves a variable
+//! frame rate output, whose average rate is what bitrate and resolution planning should work with. Stretches spread
+//! over the input are decimated concurrently to estimate it, and the result is cached per file.
+//!
+class DecimationAnalyzer final : public QObject
+{
+public:
+    explicit DecimationAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves to the fraction of frames that are kept, or to 1 when it could not be measured. An interactive
+    //! measurement runs ahead of anything queued, along with one of the same file that is already pending.
+    QFuture<double> Measure(const QString& inputPath, const Metadata& metadata, bool isInteractive = false);
+
+    //! Longest run of dropped frames, so that players can still seek and encoders still place keyframes.
+    [[nodiscard]] int maxDroppedFrames(double frameRate) const;
+
+private:
+    struct Measurement
+    {
+        QString identity;
+        QString inputPath;
+        double expectedFrames = 0;
+        double keptFrames = 0;
+        QList<QPointer<QProcess>> processes;
+        bool isInteractive = false;
+        int remaining = 0;
+        QPromise<double> promise;
+    };
+
+    void StartSample(const QSharedPointer<Measurement>& measurement, const Metadata& metadata, double startSeconds, double seconds);
+    void EndSample(const QSharedPointer<Measurement>& measurement);
+
+    const QString analysis = "Decimation";
+    const int sampleCount = 4;
+    const double sampleSeconds = 5;
+    const double maxDroppedSeconds = 2;
+    const double nominalFrameRate = 30;
+    const double minKeptFraction = 0.01;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, QSharedPointer<Measurement>> pending;
+};
+
+#endif
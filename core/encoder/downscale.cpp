@@ -0,0 +1,131 @@
+#include "downscale.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DOWNSCALE_X86
+#include <immintrin.h>
+#endif
+
+std::vector<Downscale::Kernel> Downscale::kernels()
+{
+    std::vector<Kernel> kernels { { "scalar", &Downscale::halveScalar } };
+
+#ifdef DOWNSCALE_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2"))
+        kernels.push_back({ "sse2", &Downscale::halveSse2 });
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back({ "avx2", &Downscale::halveAvx2 });
+#endif
+
+    return kernels;
+}
+
+Downscale::HalveKernel Downscale::fastestHalve()
+{
+    static const HalveKernel fastest = kernels().back().halve;
+    return fastest;
+}
+
+void Downscale::halveRow(const std::uint8_t* top, const std::uint8_t* bottom, std::uint8_t* destination, std::size_t from, std::size_t to)
+{
+    for (std::size_t x = from; x < to; x++)
+    {
+        for (std::size_t channel = 0; channel < 4; channel++)
+        {
+            const std::size_t left = x * 8 + channel;
+            const unsigned leftAverage = (top[left] + bottom[left] + 1) >> 1;
+            const unsigned rightAverage = (top[left + 4] + bottom[left + 4] + 1) >> 1;
+
+            destination[x * 4 + channel] = static_cast<std::uint8_t>((leftAverage + rightAverage + 1) >> 1);
+        }
+    }
+}
+
+void Downscale::halveScalar(
+    const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+)
+{
+    for (std::size_t y = 0; y < height; y++)
+        halveRow(source + 2 * y * sourceStride, source + (2 * y + 1) * sourceStride, destination + y * destinationStride, 0, width);
+}
+
+#ifdef DOWNSCALE_X86
+
+__attribute__((target("sse2"))) void Downscale::halveSse2(
+    const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+)
+{
+    for (std::size_t y = 0; y < height; y++)
+    {
+        const std::uint8_t* top = source + 2 * y * sourceStride;
+        const std::uint8_t* bottom = top + sourceStride;
+        std::uint8_t* row = destination + y * destinationStride;
+        std::size_t x = 0;
+
+        // 8 input pixels of both rows make 4 output pixels
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i first = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x * 8)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x * 8)));
+            const __m128i second = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x * 8 + 16)),
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x * 8 + 16)));
+
+            // pixels are 32 bits wide, so float shuffles can split them into even and odd columns
+            const __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(3, 1, 3, 1));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 4), _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd)));
+        }
+
+        halveRow(top, bottom, row, x, width);
+    }
+}
+
+__attribute__((target("avx2"))) void Downscale::halveAvx2(
+    const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+)
+{
+    for (std::size_t y = 0; y < height; y++)
+    {
+        const std::uint8_t* top = source + 2 * y * sourceStride;
+        const std::uint8_t* bottom = top + sourceStride;
+        std::uint8_t* row = destination + y * destinationStride;
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i first = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + x * 8)),
+                                                  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + x * 8)));
+            const __m256i second = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + x * 8 + 32)),
+                                                   _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + x * 8 + 32)));
+
+            const __m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(first), _mm256_castsi256_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(first), _mm256_castsi256_ps(second), _MM_SHUFFLE(3, 1, 3, 1));
+            const __m256i averaged = _mm256_avg_epu8(_mm256_castps_si256(even), _mm256_castps_si256(odd));
+
+            // shuffles stay within 128-bit lanes, which leaves the pairs of output pixels as 0, 2, 1, 3
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + x * 4), _mm256_permute4x64_epi64(averaged, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+
+        halveRow(top, bottom, row, x, width);
+    }
+}
+
+#else
+
+void Downscale::halveSse2(
+    const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+)
+{
+    halveScalar(source, sourceStride, destination, destinationStride, width, height);
+}
+
+void Downscale::halveAvx2(
+    const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+)
+{
+    halveScalar(source, sourceStride, destination, destinationStride, width, height);
+}
+
+#endif
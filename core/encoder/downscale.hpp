@@ -0,0 +1,42 @@
+#ifndef DOWNSCALE_H
+#define DOWNSCALE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//!
+//! \brief Kernels halving 32-bit pictures, for thumbnails of full-size frames.
+//! \details Each output pixel averages a 2x2 block of the input, with SSE2 or AVX2 when the CPU has them, picked once
+//! at runtime, and with plain C++ otherwise. Every kernel averages the rows first and the columns second, rounding up
+//! like pavgb, so that they all give the same bytes. Halving repeatedly takes a frame down to thumbnail size with
+//! little more work than a single pass over it. Nothing here depends on Qt, so the kernels can be benchmarked on their
+//! own.
+//!
+class Downscale
+{
+public:
+    //! Halves a picture of 2 * width by 2 * height pixels of 4 bytes into one of width by height pixels.
+    using HalveKernel = void (*)(
+        const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height
+    );
+
+    struct Kernel
+    {
+        const char* name;
+        HalveKernel halve;
+    };
+
+    //! Every kernel this CPU can run, from the slowest to the fastest.
+    [[nodiscard]] static std::vector<Kernel> kernels();
+    [[nodiscard]] static HalveKernel fastestHalve();
+
+    static void halveScalar(const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height);
+    static void halveSse2(const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height);
+    static void halveAvx2(const std::uint8_t* source, std::size_t sourceStride, std::uint8_t* destination, std::size_t destinationStride, std::size_t width, std::size_t height);
+
+private:
+    static void halveRow(const std::uint8_t* top, const std::uint8_t* bottom, std::uint8_t* destination, std::size_t from, std::size_t to);
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "duplicate_finder.hpp"
+
+#include <QImage>
+#include <QImageReader>
+#include <QtConcurrent/QtConcurrentMap>
+#include <bit>
+#include <cmath>
+
+DuplicateFinder::DuplicateFinder(AnalysisCache& cache)
+    : cache(cache)
+{
+}
+
+QFuture<QList<QStringList>> DuplicateFinder::Group(const QStringList& inputPaths)
+{
+    QList<optional<Fingerprint>> fingerprints(inputPaths.size());
+    QStringList uncachedPaths;
+    QList<qsizetype> uncachedIndices;
+
+    for (qsizetype i = 0; i < inputPaths.size(); i++)
+    {
+        if (const QStringList cached = cache.get(analysis, inputPaths[i]).toStringList(); cached.size() == 2)
+        {
+            fingerprints[i] = Fingerprint { .hash = cached[0].toULongLong(nullptr, 16), .aspectRatio = cached[1].toDouble() };
+        }
+        else
+        {
+            uncachedPaths.append(inputPaths[i]);
+            uncachedIndices.append(i);
+        }
+    }
+
+    if (uncachedPaths.isEmpty())
+        return QtFuture::makeReadyValueFuture(grouped(inputPaths, fingerprints));
+
+    return QtConcurrent::mapped(uncachedPaths, &DuplicateFinder::fingerprintOf)
+        .then(this, [=, this](const QFuture<optional<Fingerprint>>& computed)
+        {
+            QList<optional<Fingerprint>> all = fingerprints;
+            const QList<optional<Fingerprint>> results = computed.results();
+
+            for (qsizetype i = 0; i < results.size(); i++)
+            {
+                all[uncachedIndices[i]] = results[i];
+
+                // unreadable inputs are tried again next time, in case they were still being written
+                if (results[i].has_value())
+                    cache.Set(analysis, uncachedPaths[i], QStringList { QString::number(results[i]->hash, 16), QString::number(results[i]->aspectRatio) });
+            }
+
+            return grouped(inputPaths, all);
+        });
+}
+
+optional<DuplicateFinder::Fingerprint> DuplicateFinder::fingerprintOf(const QString& inputPath)
+{
+    const int hashWidth = 8;
+    const int hashHeight = 8;
+
+    QImageReader reader(inputPath);
+    const QSize size = reader.size();
+
+    // one more column than bits, since each bit compares two neighbours
+    reader.setScaledSize(QSize(hashWidth + 1, hashHeight));
+    QImage image = reader.read();
+    if (image.isNull())
+        return {};
+
+    if (image.size() != QSize(hashWidth + 1, hashHeight))
+        image = image.scaled(hashWidth + 1, hashHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    image.convertTo(QImage::Format_Grayscale8);
+
+    Fingerprint fingerprint { .aspectRatio = size.height() > 0 ? static_cast<double>(size.width()) / size.height() : 0 };
+    for (int y = 0; y < hashHeight; y++)
+    {
+        const uchar* line = image.constScanLine(y);
+
+        for (int x = 0; x < hashWidth; x++)
+            fingerprint.hash = (fingerprint.hash << 1) | (line[x] < line[x + 1] ? 1 : 0);
+    }
+
+    return fingerprint;
+}
+
+bool DuplicateFinder::isSamePicture(const Fingerprint& a, const Fingerprint& b) const
+{
+    const bool hasSameShape = a.aspectRatio <= 0 || b.aspectRatio <= 0
+                           || std::abs(a.aspectRatio - b.aspectRatio) <= maxAspectRatioDifference * qMax(a.aspectRatio, b.aspectRatio);
+
+    return hasSameShape && std::popcount(a.hash ^ b.hash) <= maxHashDistance;
+}
+
+QList<QStringList> DuplicateFinder::grouped(const QStringList& inputPaths, const QList<optional<Fingerprint>>& fingerprints) const
+{
+    QList<QStringList> groups;
+    QList<optional<Fingerprint>> keptFingerprints;
+
+    for (qsizetype i = 0; i < inputPaths.size(); i++)
+    {
+        // matching against the kept input of each group keeps a chain of small differences from merging distinct pictures
+        qsizetype group = 0;
+        if (fingerprints[i].has_value())
+        {
+            while (group < groups.size() && !(keptFingerprints[group].has_value() && isSamePicture(*keptFingerprints[group], *fingerprints[i])))
+                group++;
+        }
+        else
+        {
+            group = groups.size();
+        }
+
+        if (group < groups.size())
+        {
+            groups[group].append(inputPaths[i]);
+        }
+        else
+        {
+            groups.append({ inputPaths[i] });
+            keptFingerprints.append(fingerprints[i]);
+        }
+    }
+
+    return groups;
+}
@@ -0,0 +1,52 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include "analysis_cache.hpp"
+
+#include <QFuture>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Groups the inputs of a batch that show the same picture, so that only one of each gets converted.
+//! \details Each input is reduced to a difference hash (dHash): 64 bits telling whether each pixel of a 9x8 grayscale
+//! thumbnail is darker than its right neighbour. It survives resizing, recompression and a change of format, so copies
+//! of a picture land within a few bits of each other. Hashes are computed on the global thread pool, with the decoders
+//! scaling down while they decode, and kept in the analysis cache so that later batches do not decode the files again.
+//!
+class DuplicateFinder final : public QObject
+{
+public:
+    struct Fingerprint
+    {
+        quint64 hash = 0;
+        double aspectRatio = 0;
+    };
+
+    explicit DuplicateFinder(AnalysisCache& cache);
+
+    //! Resolves to the inputs grouped by picture, in their original order, the first input of a group being the one
+    //! to keep. An input that could not be read is a group of its own.
+    QFuture<QList<QStringList>> Group(const QStringList& inputPaths);
+
+    [[nodiscard]] static optional<Fingerprint> fingerprintOf(const QString& inputPath);
+    [[nodiscard]] bool isSamePicture(const Fingerprint& a, const Fingerprint& b) const;
+
+private:
+    [[nodiscard]] QList<QStringList> grouped(const QStringList& inputPaths, const QList<optional<Fingerprint>>& fingerprints) const;
+
+    const QString analysis = "PerceptualHash";
+    // out of 64, a recompressed copy rarely differs by more than a couple
+    const int maxHashDistance = 4;
+    // solid and gradient pictures hash alike whatever their shape, so crops and banners should not match them
+    const double maxAspectRatioDifference = 0.02;
+
+    AnalysisCache& cache;
+};
+
+#endif
@@ -1,51 +1,1210 @@
 #include "encoder.hpp"
 
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QRegularExpression>
+#include <QSharedPointer>
 #include <QStringBuilder>
+#include <QTemporaryDir>
 #include <QTime>
 #include <QVariant>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 #include "core/formats/metadata.hpp"
 #include "core/notifier/message.hpp"
+#include "encoder_options_builder.hpp"
 
-MediaEncoder::MediaEncoder()
+MediaEncoder::MediaEncoder(
+    JobScheduler& scheduler, MemoryModel& memoryModel, RateControlRegistry& rateControl, OvershootModel& overshootModel, ImageConverter& imageConverter,
+    LoudnessAnalyzer& loudnessAnalyzer, CropDetector& cropDetector, DecimationAnalyzer& decimationAnalyzer, TrimAnalyzer& trimAnalyzer,
+    DuplicateFinder& duplicateFinder, KeyframeIndex& keyframeIndex, SceneCutDetector& sceneCutDetector
+)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , rateControl(rateControl)
+    , overshootModel(overshootModel)
+    , imageConverter(imageConverter)
+    , loudnessAnalyzer(loudnessAnalyzer)
+    , cropDetector(cropDetector)
+    , decimationAnalyzer(decimationAnalyzer)
+    , trimAnalyzer(trimAnalyzer)
+    , duplicateFinder(duplicateFinder)
+    , keyframeIndex(keyframeIndex)
+    , sceneCutDetector(sceneCutDetector)
 {
+}
+
+void MediaEncoder::Encode(const EncoderOptions& options)
+{
+    if (options.videoCodec.has_value() && AnimatedImagePlanner::isAnimatedImage(*options.videoCodec))
+    {
+        if (options.splitIntoParts)
+        {
+            emit encodingFailed(tr("Animated images cannot be split into parts."));
+            return;
+        }
+
+        if (options.streamingFormat.has_value())
+        {
+            emit encodingFailed(tr("Animated images cannot be written as a stream."));
+            return;
+        }
+
+        // the palette is taken from the whole input
+        if (options.followIdleSeconds.has_value())
+        {
+            emit encodingFailed(tr("Animated images cannot be encoded from a growing input."));
+            return;
+        }
+
+        EncodeAnimatedImage(options);
+        return;
+    }
+
+    if (isInProcessImage(options) && ImageConverter::isStillImage(options.inputPath))
+    {
+        emit encodingStarted(0, 0);
+
+        auto* watcher = new QFutureWatcher<ImageConverter::Result>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [=, this]
+        {
+            const ImageConverter::Result result = watcher->result();
+            watcher->deleteLater();
+
+            if (!result.error.isEmpty())
+            {
+                emit encodingFailed(tr("Could not convert the image."), result.error);
+                return;
+            }
+
+            QFile media(result.outputPath);
+            emit encodingSucceeded(options, {}, media);
+        });
+
+        watcher->setFuture(imageConverter.Convert({ imageJobFor(options) }));
+        return;
+    }
+
+    if (smartCutPlanner.canCut(options))
+    {
+        EncodeSmartCut(options);
+        return;
+    }
+
+    if (options.splitIntoParts)
+    {
+        EncodeParts(options);
+        return;
+    }
+
+    AnalyzeInput(options, false, [=, this](const ComputedOptions& analyzed)
+    {
+        const optional<ComputedOptions> computed = ComputeOptions(options, analyzed);
+        if (!computed.has_value())
+            return;
+
+        StartCompression(options, *computed, plannedMetadata(options.inputMetadata, *computed));
+    });
+}
+
+void MediaEncoder::EncodePreview(const EncoderOptions& options, double startSeconds)
+{
+    if (options.videoCodec.has_value() && AnimatedImagePlanner::isAnimatedImage(*options.videoCodec))
+    {
+        emit encodingFailed(tr("Animated images cannot be previewed, as their size is searched for by encoding them whole."));
+        return;
+    }
+
+    if (isInProcessImage(options) && ImageConverter::isStillImage(options.inputPath))
+    {
+        emit encodingFailed(tr("Still images cannot be previewed, as they are converted about as fast as a preview would be."));
+        return;
+    }
+
+    // each part has a size budget of its own, so the excerpt is planned as the part it falls in
+    if (options.splitIntoParts)
+    {
+        PlanParts(options, true, [=, this](const ComputedOptions& analyzed, const QList<TrimAnalyzer::Trim>& trims)
+        {
+            const auto part = std::ranges::find_if(trims, [startSeconds](const TrimAnalyzer::Trim& trim)
+            {
+                return startSeconds < trim.startSeconds + trim.durationSeconds;
+            });
+
+            ComputedOptions partAnalyzed = analyzed;
+            partAnalyzed.trim = part != trims.end() ? *part : trims.last();
+
+            const optional<ComputedOptions> computed = ComputeOptions(options, partAnalyzed);
+            if (!computed.has_value())
+                return;
+
+            StartPreview(options, *computed, plannedMetadata(options.inputMetadata, *computed).durationSeconds, startSeconds);
+        });
+        return;
+    }
+
+    // the whole input is analyzed and planned for, so that the excerpt gets the bitrates the full encode would
+    AnalyzeInput(options, true, [=, this](const ComputedOptions& analyzed)
+    {
+        const optional<ComputedOptions> computed = ComputeOptions(options, analyzed);
+        if (!computed.has_value())
+            return;
+
+        StartPreview(options, *computed, plannedMetadata(options.inputMetadata, *computed).durationSeconds, startSeconds);
+    });
+}
+
+void MediaEncoder::EncodeRenditions(const std::vector<EncoderOptions>& renditions)
+{
+    if (renditions.empty())
+        return;
+
+    // renditions only differ in their geometry and bitrate, so the first one tells what the input needs analyzing for
+    AnalyzeInput(renditions.front(), false, [=, this](const ComputedOptions& analyzed)
+    {
+        std::vector<ComputedOptions> computed;
+        for (const EncoderOptions& options : renditions)
+        {
+            const optional<ComputedOptions> rendition = ComputeOptions(options, analyzed);
+            if (!rendition.has_value())
+                return;
+
+            computed.push_back(*rendition);
+        }
+
+        StartRenditions(renditions, computed);
+    });
+}
+
+void MediaEncoder::AnalyzeInput(const EncoderOptions& options, bool isInteractive, const std::function<void(const ComputedOptions&)>& next)
+{
+    struct Analysis
+    {
+        ComputedOptions analyzed;
+        int remaining = 1;
+        QString failure;
+    };
+
+    const auto analysis = QSharedPointer<Analysis>::create();
+
+    const auto finish = [=, this]
+    {
+        if (--analysis->remaining > 0)
+            return;
+
+        if (!analysis->failure.isEmpty())
+            emit encodingFailed(analysis->failure, options.inputPath);
+        else
+            next(analysis->analyzed);
+    };
+
+    // all passes run at once, each on its own process
+    if (needsLoudness(options))
+    {
+        analysis->remaining++;
+        loudnessAnalyzer.Measure(options.inputPath, isInteractive).then(this, [=, this](const optional<LoudnessAnalyzer::Measurement>& measurement)
+        {
+            if (!measurement.has_value())
+                analysis->failure = tr("Could not measure the loudness of the input. Does it contain any sound?");
+
+            analysis->analyzed.loudness = measurement;
+            finish();
+        });
+    }
+
+    if (needsCrop(options))
+    {
+        analysis->remaining++;
+        cropDetector.Detect(options.inputPath, options.inputMetadata, isInteractive).then(this, [=](const optional<QRect>& crop)
+        {
+            analysis->analyzed.crop = crop;
+            finish();
+        });
+    }
+
+    analysis->analyzed.trim = manualTrim(options);
+
+    if (options.autoTrim)
+    {
+        analysis->remaining++;
+        trimAnalyzer.Analyze(options.inputPath, options.inputMetadata, isInteractive).then(this, [=, this](const TrimAnalyzer::DeadIntervals& dead)
+        {
+            const Metadata& metadata = options.inputMetadata;
+            const bool hasAudio = encodesAudio(options) && !metadata.audioCodec.isEmpty();
+            const bool hasVideo = options.videoCodec.has_value() && metadata.width > 0;
+
+            analysis->analyzed.trim = trimAnalyzer.trimFor(dead, metadata.durationSeconds, hasAudio, hasVideo);
+            finish();
+        });
+    }
+
+    if (needsDecimation(options))
+    {
+        analysis->remaining++;
+        decimationAnalyzer.Measure(options.inputPath, options.inputMetadata, isInteractive).then(this, [=](double keptFraction)
+        {
+            analysis->analyzed.keptFrameFraction = keptFraction;
+            finish();
+        });
+    }
+
+    finish();
+}
+
+void MediaEncoder::MeasureLoudnessAhead(const QString& inputPath)
+{
+    loudnessAnalyzer.Measure(inputPath);
+}
+
+void MediaEncoder::IndexKeyframesAhead(const QString& inputPath)
+{
+    keyframeIndex.Load(inputPath);
+}
+
+bool MediaEncoder::encodesAudio(const EncoderOptions& options) const
+{
+    return options.audioCodec.has_value() && !(options.videoCodec.has_value() && AnimatedImagePlanner::isAnimatedImage(*options.videoCodec));
+}
+
+bool MediaEncoder::needsLoudness(const EncoderOptions& options) const
+{
+    return options.loudnessLufs.has_value() && encodesAudio(options) && options.audioCodec->libraryName != "copy";
+}
+
+bool MediaEncoder::needsCrop(const EncoderOptions& options) const
+{
+    return options.autoCrop && options.videoCodec.has_value() && options.videoCodec->libraryName != "copy";
+}
+
+bool MediaEncoder::needsDecimation(const EncoderOptions& options) const
+{
+    return options.decimate && options.videoCodec.has_value() && options.videoCodec->libraryName != "copy";
+}
+
+optional<TrimAnalyzer::Trim> MediaEncoder::manualTrim(const EncoderOptions& options) const
+{
+    if (!options.trimStartSeconds.has_value() && !options.trimEndSeconds.has_value())
+        return {};
+
+    const double duration = options.inputMetadata.durationSeconds;
+    const double startSeconds = options.trimStartSeconds.value_or(0);
+    const double endSeconds = duration > 0 ? qMin(duration, options.trimEndSeconds.value_or(duration)) : options.trimEndSeconds.value_or(0);
+
+    if (endSeconds <= startSeconds)
+        return {};
+
+    return TrimAnalyzer::Trim { .startSeconds = startSeconds, .durationSeconds = endSeconds - startSeconds };
+}
+
+void MediaEncoder::ConvertImages(const std::vector<EncoderOptions>& images)
+{
+    QHash<QString, ImageConverter::Job> jobs;
+    QStringList inputPaths;
+
+    for (const EncoderOptions& options : images)
+    {
+        if (!isInProcessImage(options))
+        {
+            emit encodingFailed(tr("Choose an image codec such as PNG, MJPEG or WebP to convert a batch of images."), options.inputPath);
+            return;
+        }
+
+        jobs.insert(options.inputPath, imageJobFor(options));
+        inputPaths.append(options.inputPath);
+    }
+
+    emit encodingStarted(0, 0);
+
+    duplicateFinder.Group(inputPaths).then(this, [=, this](const QList<QStringList>& groups)
+    {
+        QList<ImageConverter::Job> keptJobs;
+        QList<ImageConverter::Result> skipped;
+
+        for (const QStringList& group : groups)
+        {
+            keptJobs.append(jobs[group.first()]);
+
+            for (qsizetype i = 1; i < group.size(); i++)
+                skipped.append({ .outputPath = jobs[group[i]].outputPath, .duplicateOf = group.first() });
+        }
+
+        auto* watcher = new QFutureWatcher<ImageConverter::Result>(this);
+        connect(watcher, &QFutureWatcherBase::progressValueChanged, this, [=, this](int progress)
+        {
+            emit encodingProgressUpdate(100.0 * progress / qMax(1, watcher->progressMaximum()));
+        });
+        connect(watcher, &QFutureWatcherBase::finished, this, [=, this]
+        {
+            const QList<ImageConverter::Result> results = watcher->future().results() + skipped;
+            watcher->deleteLater();
+
+            emit imagesConverted(results);
+        });
+
+        watcher->setFuture(imageConverter.Convert(keptJobs));
+    });
+}
+
+bool MediaEncoder::isInProcessImage(const EncoderOptions& options) const
+{
+    // retiming and custom FFmpeg arguments need FFmpeg, while an audio codec has nothing to encode in a still image
+    const bool needsFFmpeg = options.speed.has_value() || options.fps.has_value() || options.aspectRatio.has_value()
+                          || !options.customArguments.value_or("").trimmed().isEmpty();
+
+    return options.videoCodec.has_value() && !needsFFmpeg && !ImageConverter::formatFor(*options.videoCodec).isEmpty();
+}
+
+ImageConverter::Job MediaEncoder::imageJobFor(const EncoderOptions& options) const
+{
+    return {
+        .inputPath = options.inputPath,
+        .outputPath = options.outputPath,
+        .format = ImageConverter::formatFor(*options.videoCodec),
+        .qualityPercent = options.constantQualityPercent,
+        .sizeKbps = options.sizeKbps,
+        .size = QSize(options.outputWidth.value_or(0), options.outputHeight.value_or(0)),
+    };
+}
+
+optional<MediaEncoder::ComputedOptions> MediaEncoder::ComputeOptions(const EncoderOptions& options, const ComputedOptions& analyzed) const
+{
+    const Metadata metadata = plannedMetadata(options.inputMetadata, analyzed);
+
+    ComputedOptions computed = analyzed;
+
+    // outputs with video are only corrected through their video bitrate, once their geometry is known
+    if (options.sizeKbps.has_value() && !options.videoCodec.has_value() && options.audioCodec.has_value() && options.audioCodec->libraryName != "copy")
+        computed.sizeCorrection = overshootModel.CorrectionFor(*options.audioCodec, options.container, 0);
+
+    if (options.audioCodec.has_value())
+    {
+        if (!computeAudioBitrate(options, computed))
+            return {};
+    }
+
+    if (options.videoCodec.has_value() && options.sizeKbps.has_value())
+    {
+        // taken before automatic resolution lowers the geometry for a short bitrate, which must not lower it again
+        const double pixelRatio = computePixelRatio(options, computed, metadata);
+        ComputeVideoBitrate(options, computed, metadata, pixelRatio);
+        ComputeOutputResolution(options, computed, metadata);
+
+        // the overshoot profile follows the geometry the output ends up with, so the bitrate is planned again with it
+        if (options.videoCodec->libraryName != "copy")
+        {
+            computed.sizeCorrection = overshootModel.CorrectionFor(*options.videoCodec, options.container, BuildVideoFilterGraph(options, computed).output().height);
+            ComputeVideoBitrate(options, computed, metadata, pixelRatio);
+        }
+    }
+    else if (options.videoBitrateKbps.has_value())
+    {
+        computed.videoBitrateKbps = *options.videoBitrateKbps;
+    }
+
+    return computed;
+}
+
+void MediaEncoder::StartCompression(const EncoderOptions& options, const ComputedOptions& computed, const Metadata& metadata)
+{
+    emit encodingStarted(computed.videoBitrateKbps.value_or(0), computed.audioBitrateKbps.value_or(0));
+
+    const auto maybeOutputPath = PrepareOutputPath(options, options.outputPath);
+    if (std::holds_alternative<Message>(maybeOutputPath))
+    {
+        emit encodingFailed(std::get<Message>(maybeOutputPath).message);
+        return;
+    }
+
+    const QString outputPath = std::get<QString>(maybeOutputPath);
+
+    MemoryModel::Estimate memoryEstimate = memoryModel.EstimatePeak(metadata, options.videoCodec);
+    const QString command = BuildCompressionCommand(options, computed, outputPath, memoryEstimate);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryEstimate });
     ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
-    connect(ffmpeg, &QProcess::errorOccurred, [this](QProcess::ProcessError error)
+
+    const auto output = QSharedPointer<QString>::create();
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
     {
         emit encodingFailed(tr("Process %1").arg(QVariant::fromValue(error).toString()));
     });
+
+    const auto segments = QSharedPointer<qsizetype>::create(0);
+
+    connect(ffmpeg, &QProcess::readyRead, this, [=, this]
+    {
+        const qsizetype seen = output->size();
+        if (options.followIdleSeconds.has_value())
+            UpdateGrowingProgress(ffmpeg, *output, options);
+        else
+            UpdateProgress(ffmpeg, *output, metadata.durationSeconds);
+
+        if (options.streamingFormat.has_value() && options.streamingFormat != StreamingFormat::FragmentedMp4)
+            CountSegments(options, outputPath, output->sliced(seen), *segments);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        EndCompression(options, computed, outputPath, command, exitCode, *output);
+    });
 }
 
-void MediaEncoder::Encode(const EncoderOptions& options)
+void MediaEncoder::CountSegments(const EncoderOptions& options, const QString& playlistPath, const QString& output, qsizetype& opened)
+{
+    // DASH writes segments for every stream, so only those of the first one are counted
+    const QString name = QFileInfo(playlistPath).completeBaseName() + (options.streamingFormat == StreamingFormat::Dash ? "_0" : "");
+    const QRegularExpression regex(QString(R"(Opening '[^']*%1_\d{5}\.m4s(?:\.tmp)?' for writing)").arg(QRegularExpression::escape(name)));
+    const qsizetype previous = opened;
+
+    for ([[maybe_unused]] const QRegularExpressionMatch& match : regex.globalMatch(output))
+        opened++;
+
+    // a segment is complete once the muxer moves on to the next one
+    if (opened > previous && opened > 1)
+        emit segmentsWritten(playlistPath, opened - 1);
+}
+
+void MediaEncoder::StartPreview(const EncoderOptions& options, const ComputedOptions& computed, double plannedSeconds, double startSeconds)
+{
+    if (!previewDirectory.isValid())
+    {
+        emit encodingFailed(tr("Could not create a folder for previews."), previewDirectory.errorString());
+        return;
+    }
+
+    // the excerpt stays inside what is kept, moved back from the end so that it is as long as it can be
+    const double keptStartSeconds = computed.trim.has_value() ? computed.trim->startSeconds : 0;
+    const double excerptSeconds = plannedSeconds > 0 ? qMin(previewSeconds, plannedSeconds) : previewSeconds;
+    const double latestStartSeconds = keptStartSeconds + qMax(0.0, plannedSeconds - excerptSeconds);
+
+    ComputedOptions excerpt = computed;
+    excerpt.trim = TrimAnalyzer::Trim { .startSeconds = qBound(keptStartSeconds, startSeconds, latestStartSeconds), .durationSeconds = excerptSeconds };
+
+    // each preview gets its own file, as the previous one may still be open in a player
+    const auto maybeOutputPath = PrepareOutputPath(options, previewDirectory.filePath(QString("preview-%1").arg(++previewCount)));
+    if (std::holds_alternative<Message>(maybeOutputPath))
+    {
+        emit encodingFailed(std::get<Message>(maybeOutputPath).message);
+        return;
+    }
+
+    const QString outputPath = std::get<QString>(maybeOutputPath);
+
+    MemoryModel::Estimate memoryEstimate = memoryModel.EstimatePeak(plannedMetadata(options.inputMetadata, excerpt), options.videoCodec);
+    const QString command = BuildCompressionCommand(options, excerpt, outputPath, memoryEstimate);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryEstimate, .isInteractive = true });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    struct Timing
+    {
+        QElapsedTimer timer;
+        // as of the first progress line, once FFmpeg has opened the input and its encoders
+        optional<double> startupSeconds;
+        double startupEncodedSeconds = 0;
+    };
+
+    const auto output = QSharedPointer<QString>::create();
+    const auto timing = QSharedPointer<Timing>::create();
+
+    connect(ffmpeg, &QProcess::started, this, [=]
+    {
+        timing->timer.start();
+    });
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
+    {
+        emit encodingFailed(tr("Process %1").arg(QVariant::fromValue(error).toString()));
+    });
+
+    connect(ffmpeg, &QProcess::readyRead, this, [=, this]
+    {
+        UpdateProgress(ffmpeg, *output, excerptSeconds);
+
+        if (timing->startupSeconds.has_value())
+            return;
+
+        if (const optional<double> seconds = parseProgressSeconds(*output); seconds.has_value())
+        {
+            timing->startupSeconds = timing->timer.elapsed() / 1000.0;
+            timing->startupEncodedSeconds = *seconds;
+        }
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0 || !QFileInfo::exists(outputPath))
+        {
+            emit encodingFailed(parseOutput(*output), command + "\n\n" + *output);
+            return;
+        }
+
+        // the container overhead is paid once however long the output is
+        const double excerptKbps = qMax(0.0, outputSizeKb(options, outputPath) - containerHeaderKb);
+        const double scale = plannedSeconds > 0 ? plannedSeconds / excerptSeconds : 1;
+
+        // the startup is paid once as well, only the encoding that follows it scales with the duration
+        const double elapsedSeconds = timing->timer.elapsed() / 1000.0;
+        double projectedSeconds = elapsedSeconds * scale;
+        if (timing->startupSeconds.has_value() && excerptSeconds > timing->startupEncodedSeconds)
+        {
+            const double secondsPerSecond = (elapsedSeconds - *timing->startupSeconds) / (excerptSeconds - timing->startupEncodedSeconds);
+            projectedSeconds = *timing->startupSeconds + secondsPerSecond * (plannedSeconds > 0 ? plannedSeconds : excerptSeconds);
+        }
+
+        emit previewEncoded(outputPath, excerptKbps * scale + containerHeaderKb, projectedSeconds);
+    });
+}
+
+void MediaEncoder::StartRenditions(const std::vector<EncoderOptions>& renditions, const std::vector<ComputedOptions>& computed)
+{
+    const EncoderOptions& first = renditions.front();
+    emit encodingStarted(computed.front().videoBitrateKbps.value_or(0), computed.front().audioBitrateKbps.value_or(0));
+
+    QStringList videoBranches;
+    QStringList audioBranches;
+    QStringList outputs;
+    QStringList outputPaths;
+    MemoryModel::Estimate memoryEstimate { .profile = "renditions" };
+
+    // each rendition that re-encodes gets its own branch of the decoded stream, stream copies map the input directly
+    const auto branch = [](QStringList& branches, const QString& label, const QString& filters, const QString& passthrough)
+    {
+        branches.append(QString("[%1s]%2[%1]").arg(label, filters.isEmpty() ? passthrough : filters));
+        return "[" + label + "]";
+    };
+
+    for (size_t i = 0; i < renditions.size(); i++)
+    {
+        const EncoderOptions& options = renditions[i];
+        const auto maybeFileExtension = extensionForContainer(options.container);
+        if (std::holds_alternative<Message>(maybeFileExtension))
+        {
+            emit encodingFailed(std::get<Message>(maybeFileExtension).message);
+            return;
+        }
+
+        const QString outputPath = options.outputPath + "." + std::get<QString>(maybeFileExtension);
+        outputPaths.append(outputPath);
+
+        QStringList maps;
+        if (options.videoCodec.has_value())
+        {
+            const bool isCopy = options.videoCodec->libraryName == "copy";
+            maps.append("-map " + (isCopy ? "0:v:0" : branch(videoBranches, QString("v%1").arg(i), BuildVideoFilterGraph(options, computed[i]).toString(), "null")));
+        }
+        // a branch of an audio stream the input does not have would fail the whole graph
+        if (options.audioCodec.has_value() && !options.inputMetadata.audioCodec.isEmpty())
+        {
+            const bool isCopy = options.audioCodec->libraryName == "copy";
+            maps.append("-map " + (isCopy ? "0:a:0?" : branch(audioBranches, QString("a%1").arg(i), BuildAudioFilters(options, computed[i]), "anull")));
+        }
+        else
+        {
+            maps.append("-an");
+        }
+        // explicit maps turn off the automatic selection, which would have kept a subtitle stream as a single output does
+        if (options.videoCodec.has_value())
+            maps.append("-map 0:s:0? -c:s copy");
+
+        MemoryModel::Estimate renditionEstimate = memoryModel.EstimatePeak(options.inputMetadata, options.videoCodec);
+        const QString memoryLimitParams = BuildMemoryLimitParams(options, renditionEstimate);
+        memoryEstimate.formulaMb += renditionEstimate.formulaMb;
+        memoryEstimate.peakMb += renditionEstimate.peakMb;
+
+        outputs.append(QString(R"(%1 %2 %3 %4 "%5")").arg(maps.join(' '), BuildBaseParams(options, computed[i]), memoryLimitParams, options.customArguments.value_or(""), outputPath));
+    }
+
+    const auto splitInto = [](const QString& filter, const QString& input, const QStringList& branches)
+    {
+        QString split = QString("[%1]%2=%3").arg(input, filter).arg(branches.size());
+        for (const QString& branch : branches)
+            split += branch.section(']', 0, 0) + "]";
+
+        return QStringList { split } + branches;
+    };
+
+    QStringList graph;
+    if (!videoBranches.isEmpty())
+        graph += splitInto("split", "0:v", videoBranches);
+    if (!audioBranches.isEmpty())
+        graph += splitInto("asplit", "0:a", audioBranches);
+
+    const QString filterComplex = graph.isEmpty() ? "" : QString(R"(-filter_complex "%1")").arg(graph.join(';'));
+    // every rendition shares the analysis of the input, and with it the trim
+    const QString command = QString(R"(ffmpeg -y %1 -i "%2" %3 %4)").arg(BuildInputParams(computed.front()), first.inputPath, filterComplex, outputs.join(' '));
+    const double durationSeconds = plannedMetadata(first.inputMetadata, computed.front()).durationSeconds;
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryEstimate });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    const auto output = QSharedPointer<QString>::create();
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
+    {
+        emit encodingFailed(tr("Process %1").arg(QVariant::fromValue(error).toString()));
+    });
+
+    connect(ffmpeg, &QProcess::readyRead, this, [=, this]
+    {
+        UpdateProgress(ffmpeg, *output, durationSeconds);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        EndRenditions(renditions, computed, outputPaths, command, exitCode, *output);
+    });
+}
+
+struct MediaEncoder::LadderProbes
+{
+    QTemporaryDir directory;
+    QString fileExtension;
+    double excerptStart = 0;
+    double excerptSeconds = 0;
+    QList<BitrateLadder::Probe> probes;
+    qsizetype remaining = 0;
+};
+
+void MediaEncoder::OptimizeLadder(const EncoderOptions& options)
 {
-    const Metadata metadata = options.inputMetadata;
+    if (!options.videoCodec.has_value() || options.videoCodec->libraryName == "copy")
+    {
+        emit encodingFailed(tr("A per-title ladder needs a video codec to encode with."));
+        return;
+    }
+
+    // every rung gets its own bitrate, so whatever was asked for the single output no longer applies
+    // the probes are planned on the full picture, which a crop would distort
+    const auto maybeOptions = EncoderOptionsBuilder(options).withTargetOutputSize(0).withConstantQuality(0).withVideoBitrate(0).withAutoResolution(false).withAutoCrop(false).build();
+    if (std::holds_alternative<QList<QString>>(maybeOptions))
+    {
+        emit encodingFailed(tr("Invalid encoding options"), std::get<QList<QString>>(maybeOptions).join("\n"));
+        return;
+    }
+
+    const EncoderOptions base = std::get<EncoderOptions>(maybeOptions);
+
+    const auto maybeFileExtension = extensionForContainer(base.container);
+    if (std::holds_alternative<Message>(maybeFileExtension))
+    {
+        emit encodingFailed(std::get<Message>(maybeFileExtension).message);
+        return;
+    }
+
+    const double durationSeconds = base.inputMetadata.durationSeconds;
+    const auto probes = QSharedPointer<LadderProbes>::create();
+    probes->fileExtension = std::get<QString>(maybeFileExtension);
+    probes->excerptSeconds = qMin(bitrateLadder.excerptSeconds, durationSeconds);
+    probes->excerptStart = qMax(0.0, (durationSeconds - probes->excerptSeconds) / 2);
+    probes->probes = bitrateLadder.probesFor(base.inputMetadata);
+    probes->remaining = probes->probes.size();
+
+    if (!probes->directory.isValid() || probes->probes.isEmpty())
+    {
+        emit encodingFailed(tr("Could not prepare the probe encodes for the ladder."), probes->directory.errorString());
+        return;
+    }
+
+    emit encodingStarted(0, 0);
+
+    // the renditions wait for the loudness of the input, which can be measured while the probes run
+    if (needsLoudness(base))
+        loudnessAnalyzer.Measure(base.inputPath);
+
+    for (qsizetype i = 0; i < probes->probes.size(); i++)
+        StartLadderProbe(base, probes, i);
+}
+
+void MediaEncoder::StartLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes, qsizetype index)
+{
+    const BitrateLadder::Probe& probe = probes->probes[index];
+    const ComputedOptions computed { .videoBitrateKbps = probe.bitrateKbps, .outputWidth = probe.width, .outputHeight = probe.height };
+
+    const QString probePath = probes->directory.filePath(QString("probe%1.%2").arg(index).arg(probes->fileExtension));
+    const QString command = QString(R"(ffmpeg -ss %1 -t %2 -i "%3" %4 %5 -an "%6" -y)")
+                                .arg(QString::number(probes->excerptStart), QString::number(probes->excerptSeconds), options.inputPath,
+                                     BuildBaseParams(options, computed), BuildVideoFilterParams(options, computed), probePath);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(options.inputMetadata, options.videoCodec) });
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndLadderProbe(options, probes);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode == 0)
+            ScoreLadderProbe(options, probes, index);
+        else
+            EndLadderProbe(options, probes);
+    });
+}
+
+void MediaEncoder::ScoreLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes, qsizetype index)
+{
+    const FilterGraph reference = BuildVideoFilterGraph(options, {});
+    const QString referenceFilters = reference.isEmpty() ? "setsar=1" : reference.toString() + ",setsar=1";
+
+    // probes are scaled back up, so they are scored the way a player would show them in place of the best rung
+    const QString graph = QString("[0:v]%1[reference];[1:v]scale=%2:%3:flags=bicubic,setsar=1[probe];[probe][reference]ssim")
+                              .arg(referenceFilters, QString::number(reference.output().width), QString::number(reference.output().height));
+
+    const QString probePath = probes->directory.filePath(QString("probe%1.%2").arg(index).arg(probes->fileExtension));
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -ss %1 -t %2 -i "%3" -i "%4" -lavfi "%5" -f null -)")
+                                .arg(QString::number(probes->excerptStart), QString::number(probes->excerptSeconds), options.inputPath, probePath, graph);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(options.inputMetadata, {}) });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndLadderProbe(options, probes);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        static const QRegularExpression regex(R"(SSIM .*All:([0-9.]+))");
+        const QRegularExpressionMatch match = regex.match(ffmpeg->readAll());
+
+        if (exitCode == 0 && match.hasMatch())
+            probes->probes[index].qualityDb = BitrateLadder::ssimToDecibels(match.captured(1).toDouble());
+
+        EndLadderProbe(options, probes);
+    });
+}
+
+void MediaEncoder::EndLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes)
+{
+    probes->remaining--;
+    emit encodingProgressUpdate(100.0 * (probes->probes.size() - probes->remaining) / probes->probes.size());
+
+    if (probes->remaining > 0)
+        return;
+
+    QList<BitrateLadder::Probe> scored;
+    for (const BitrateLadder::Probe& probe : probes->probes)
+    {
+        if (probe.qualityDb > 0)
+            scored.append(probe);
+    }
+
+    const QList<BitrateLadder::Probe> rungs = bitrateLadder.rungs(bitrateLadder.convexHull(scored));
+    if (rungs.isEmpty())
+    {
+        emit encodingFailed(tr("None of the probe encodes for the ladder succeeded."));
+        return;
+    }
+
+    std::vector<EncoderOptions> renditions;
+    for (const BitrateLadder::Probe& rung : rungs)
+    {
+        const auto maybeRung = EncoderOptionsBuilder(options)
+                                   .outputTo(QString("%1_%2p_%3k").arg(options.outputPath).arg(rung.height).arg(rung.bitrateKbps))
+                                   .withVideoBitrate(rung.bitrateKbps)
+                                   .withOutputWidth(rung.width)
+                                   .withOutputHeight(rung.height)
+                                   .build();
+
+        if (std::holds_alternative<QList<QString>>(maybeRung))
+        {
+            emit encodingFailed(tr("Invalid encoding options"), std::get<QList<QString>>(maybeRung).join("\n"));
+            return;
+        }
+
+        renditions.push_back(std::get<EncoderOptions>(maybeRung));
+    }
+
+    emit ladderOptimized(renditions);
+}
+
+struct MediaEncoder::SmartCut
+{
+    QTemporaryDir directory;
+    QString outputPath;
+    TrimAnalyzer::Trim trim;
+    QStringList segmentPaths;
+    qsizetype remaining = 0;
+    QString failure;
+};
+
+void MediaEncoder::EncodeSmartCut(const EncoderOptions& options)
+{
+    const auto maybeFileExtension = extensionForContainer(options.container);
+    if (std::holds_alternative<Message>(maybeFileExtension))
+    {
+        emit encodingFailed(std::get<Message>(maybeFileExtension).message);
+        return;
+    }
+
+    const optional<TrimAnalyzer::Trim> trim = manualTrim(options);
+    const auto cut = QSharedPointer<SmartCut>::create();
+
+    if (!trim.has_value() || !cut->directory.isValid())
+    {
+        emit encodingFailed(tr("Could not prepare the trimmed parts."), cut->directory.errorString());
+        return;
+    }
+
+    cut->outputPath = options.outputPath + "." + std::get<QString>(maybeFileExtension);
+    cut->trim = *trim;
+
+    emit encodingStarted(0, 0);
+
+    keyframeIndex.Load(options.inputPath).then(this, [=, this](const KeyframeIndex::Map& keyframes)
+    {
+        const double endSeconds = cut->trim.startSeconds + cut->trim.durationSeconds;
+        const QList<SmartCutPlanner::Segment> segments = smartCutPlanner.segmentsFor(cut->trim.startSeconds, endSeconds, keyframes, options.inputMetadata.frameRate);
+
+        cut->remaining = segments.size();
+        cut->segmentPaths.resize(segments.size());
+
+        // the copied middle and both edges run at once
+        for (qsizetype i = 0; i < segments.size(); i++)
+            StartSmartCutSegment(options, cut, segments[i], i);
+    });
+}
+
+void MediaEncoder::StartSmartCutSegment(const EncoderOptions& options, const QSharedPointer<SmartCut>& cut, const SmartCutPlanner::Segment& segment, qsizetype index)
+{
+    const SmartCutPlanner::EdgeEncoder encoder = smartCutPlanner.edgeEncoderFor(options.inputMetadata.videoCodec);
+    const QString segmentPath = cut->directory.filePath(QString("segment%1").arg(index));
+    cut->segmentPaths[index] = segmentPath;
+
+    // seeking lands on the last keyframe at or before the given time, which must not be the one before a copied part
+    const double seekSeconds = segment.isCopied ? segment.startSeconds + 0.001 : segment.startSeconds;
+    const QString videoParams = segment.isCopied ? "-c:v copy" : encoder.params;
+    const QString audioParams = options.audioCodec.has_value() ? "-map 0:a? -c:a copy" : "-an";
+
+    const QString command = QString(R"(ffmpeg -hide_banner -ss %1 -i "%2" -t %3 -map 0:v:0 %4 %5 -sn -avoid_negative_ts make_zero -f %6 "%7" -y)")
+                                .arg(QString::number(seekSeconds), options.inputPath, QString::number(segment.durationSeconds), videoParams, audioParams,
+                                     encoder.intermediateFormat, segmentPath);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(options.inputMetadata, {}) });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error != QProcess::FailedToStart)
+            return;
+
+        cut->failure = tr("Process %1").arg(QVariant::fromValue(error).toString());
+        EndSmartCutSegment(options, cut);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0)
+            cut->failure = command + "\n\n" + ffmpeg->readAll();
+
+        EndSmartCutSegment(options, cut);
+    });
+}
+
+void MediaEncoder::EndSmartCutSegment(const EncoderOptions& options, const QSharedPointer<SmartCut>& cut)
+{
+    cut->remaining--;
+
+    // joining the parts is one more step, though a quick one
+    const qsizetype count = cut->segmentPaths.size();
+    emit encodingProgressUpdate(100.0 * (count - cut->remaining) / (count + 1));
+
+    if (cut->remaining > 0)
+        return;
+
+    if (!cut->failure.isEmpty())
+    {
+        emit encodingFailed(parseOutput(cut->failure), cut->failure);
+        return;
+    }
+
+    QFile list(cut->directory.filePath("segments.txt"));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        emit encodingFailed(tr("Could not prepare the trimmed parts."), list.errorString());
+        return;
+    }
+
+    for (QString path : cut->segmentPaths)
+        list.write(QString("file '%1'\n").arg(path.replace("'", R"('\'')")).toUtf8());
+
+    list.close();
+
+    const QString command = QString(R"(ffmpeg -hide_banner -f concat -safe 0 -i "%1" -map 0 -c copy -f %2 "%3" -y)")
+                                .arg(list.fileName(), options.container.formatName, cut->outputPath);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak({}, {}) });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            emit encodingFailed(tr("Process %1").arg(QVariant::fromValue(error).toString()));
+    });
+
+    // the parts live in the temporary directory, which has to outlast the process
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        EndCompression(options, { .trim = cut->trim }, cut->outputPath, command, exitCode, QString(ffmpeg->readAll()));
+    });
+}
+
+struct MediaEncoder::Parts
+{
+    QStringList outputPaths;
+    QList<double> durations;
+    QList<double> encodedSeconds;
+    qsizetype remaining = 0;
+    QString failure;
+    QString failureDetails;
+};
+
+void MediaEncoder::EncodeParts(const EncoderOptions& options)
+{
+    PlanParts(options, false, [=, this](const ComputedOptions& analyzed, const QList<TrimAnalyzer::Trim>& trims)
+    {
+        StartParts(options, analyzed, trims);
+    });
+}
+
+void MediaEncoder::PlanParts(
+    const EncoderOptions& options, bool isInteractive, const std::function<void(const ComputedOptions&, const QList<TrimAnalyzer::Trim>&)>& next
+)
+{
+    AnalyzeInput(options, isInteractive, [=, this](const ComputedOptions& analyzed)
+    {
+        const auto start = [=, this](const QList<double>& sceneCuts)
+        {
+            keyframeIndex.Load(options.inputPath).then(this, [=, this](const KeyframeIndex::Map& keyframes)
+            {
+                const QList<TrimAnalyzer::Trim> trims = partsFor(options, analyzed, keyframes, sceneCuts);
+                if (trims.isEmpty())
+                {
+                    emit encodingFailed(tr("Even %1 parts would not fit the desired file size at a watchable bitrate.").arg(maxParts));
+                    return;
+                }
+
+                next(analyzed, trims);
+            });
+        };
+
+        // finding scene cuts decodes the whole input, while the keyframes are read from its packets without decoding any
+        if (!options.snapToSceneCuts)
+        {
+            start({});
+            return;
+        }
+
+        // the detector indexes the keyframes on its way, so the index is ready once the cuts are
+        sceneCutDetector.Detect(options.inputPath, options.inputMetadata).then(this, start);
+    });
+}
+
+QList<TrimAnalyzer::Trim> MediaEncoder::partsFor(
+    const EncoderOptions& options, const ComputedOptions& analyzed, const KeyframeIndex::Map& keyframes, const QList<double>& sceneCuts
+) const
+{
+    const double startSeconds = analyzed.trim.has_value() ? analyzed.trim->startSeconds : 0;
+    const double endSeconds = startSeconds + plannedMetadata(options.inputMetadata, analyzed).durationSeconds;
+
+    for (int count = 1; count <= maxParts; count++)
+    {
+        const double partSeconds = (endSeconds - startSeconds) / count;
+        // a scene cut is worth a part a little longer than the others
+        const double sceneCutReach = partSeconds / 10;
+
+        QList<TrimAnalyzer::Trim> trims;
+        double partStart = startSeconds;
+
+        for (int i = 1; i < count; i++)
+        {
+            const double target = startSeconds + i * partSeconds;
+            double boundary = target;
+
+            const auto sceneCut = std::ranges::min_element(sceneCuts, {}, [target](double cut) { return std::abs(cut - target); });
+            if (sceneCut != sceneCuts.end() && std::abs(*sceneCut - target) <= sceneCutReach)
+                boundary = *sceneCut;
+            else if (const optional<KeyframeIndex::Keyframe> keyframe = keyframes.nearest(target); keyframe.has_value())
+                boundary = keyframe->seconds;
+
+            // keyframes too sparse for this many parts would leave one of them empty
+            if (boundary <= partStart || boundary >= endSeconds)
+                boundary = target;
+
+            trims.append({ .startSeconds = partStart, .durationSeconds = boundary - partStart });
+            partStart = boundary;
+        }
+
+        trims.append({ .startSeconds = partStart, .durationSeconds = endSeconds - partStart });
+
+        if (std::ranges::all_of(trims, [&](const TrimAnalyzer::Trim& trim) { return fitsPart(options, analyzed, trim); }))
+            return trims;
+    }
+
+    return {};
+}
+
+bool MediaEncoder::fitsPart(const EncoderOptions& options, const ComputedOptions& analyzed, const TrimAnalyzer::Trim& part) const
+{
+    ComputedOptions partAnalyzed = analyzed;
+    partAnalyzed.trim = part;
+
+    const optional<ComputedOptions> computed = ComputeOptions(options, partAnalyzed);
+    if (!computed.has_value() || !computed->videoBitrateKbps.has_value())
+        return false;
+
+    // a bitrate held up by its floor would overshoot the size instead of fitting it
+    if (*computed->videoBitrateKbps <= options.minVideoBitrateKbps)
+        return false;
+
+    // the picture that was asked for, before the resolution ladder lowers it to fit
+    const FilterGraph::StreamState picture = BuildVideoFilterGraph(options, partAnalyzed).output();
+
+    // the floor is all there is to go by when the picture is not known, as the resolution ladder does not step in either
+    if (picture.width <= 0 || picture.height <= 0 || picture.frameRate <= 0)
+        return true;
+
+    const double bitsPerPixel = *computed->videoBitrateKbps * 1000 / (picture.width * picture.height * picture.frameRate);
+
+    return bitsPerPixel >= resolutionLadder.minBitsPerPixel(*options.videoCodec);
+}
+
+void MediaEncoder::StartParts(const EncoderOptions& options, const ComputedOptions& analyzed, const QList<TrimAnalyzer::Trim>& trims)
+{
+    const auto maybeFileExtension = extensionForContainer(options.container);
+    if (std::holds_alternative<Message>(maybeFileExtension))
+    {
+        emit encodingFailed(std::get<Message>(maybeFileExtension).message);
+        return;
+    }
+
+    const auto parts = QSharedPointer<Parts>::create();
+    parts->encodedSeconds.resize(trims.size());
+    parts->remaining = trims.size();
+
+    std::vector<ComputedOptions> computed;
+    for (const TrimAnalyzer::Trim& trim : trims)
+    {
+        ComputedOptions partAnalyzed = analyzed;
+        partAnalyzed.trim = trim;
+
+        const optional<ComputedOptions> part = ComputeOptions(options, partAnalyzed);
+        if (!part.has_value())
+            return;
+
+        computed.push_back(*part);
+        parts->durations.append(trim.durationSeconds);
+        parts->outputPaths.append(QString("%1_%2.%3").arg(options.outputPath).arg(parts->outputPaths.size() + 1, 2, 10, QChar('0')).arg(std::get<QString>(maybeFileExtension)));
+    }
 
-    ComputedOptions computed;
+    // parts are about as long as each other, so the bitrates of the first tell what to expect of the others
+    emit encodingStarted(computed.front().videoBitrateKbps.value_or(0), computed.front().audioBitrateKbps.value_or(0));
 
-    if (options.audioCodec.has_value())
+    for (qsizetype i = 0; i < trims.size(); i++)
     {
-        if (!computeAudioBitrate(options, computed))
-            return;
+        const ComputedOptions& part = computed[i];
+        const QString outputPath = parts->outputPaths[i];
+
+        MemoryModel::Estimate memoryEstimate = memoryModel.EstimatePeak(plannedMetadata(options.inputMetadata, part), options.videoCodec);
+        const QString command = BuildCompressionCommand(options, part, outputPath, memoryEstimate);
+
+        QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryEstimate });
+        ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+        const auto output = QSharedPointer<QString>::create();
+
+        connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+        {
+            if (error != QProcess::FailedToStart)
+                return;
+
+            parts->failure = tr("Process %1").arg(QVariant::fromValue(error).toString());
+            EndPart(options, parts);
+        });
+
+        connect(ffmpeg, &QProcess::readyRead, this, [=, this]
+        {
+            const QString line(ffmpeg->readAll());
+            *output += line;
+
+            if (const optional<double> seconds = parseProgressSeconds(line); seconds.has_value())
+            {
+                parts->encodedSeconds[i] = qMin(*seconds, parts->durations[i]);
+
+                const double total = std::accumulate(parts->durations.begin(), parts->durations.end(), 0.0);
+                const double encoded = std::accumulate(parts->encodedSeconds.begin(), parts->encodedSeconds.end(), 0.0);
+                emit encodingProgressUpdate(encoded * 100 / total);
+            }
+        });
+
+        connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+        {
+            const QFileInfo media(outputPath);
+            if (exitCode != 0 || !media.exists())
+            {
+                parts->failure = parseOutput(*output);
+                parts->failureDetails = command + "\n\n" + *output;
+            }
+            else
+            {
+                RecordOvershoot(options, part, media.size() / 125.0);
+            }
+
+            EndPart(options, parts);
+        });
     }
+}
 
-    if (options.videoCodec.has_value() && options.sizeKbps.has_value())
+void MediaEncoder::EndPart(const EncoderOptions& options, const QSharedPointer<Parts>& parts)
+{
+    if (--parts->remaining > 0)
+        return;
+
+    if (!parts->failure.isEmpty())
     {
-        ComputeVideoBitrate(options, computed, metadata);
+        emit encodingFailed(parts->failure, parts->failureDetails);
+        return;
     }
 
-    StartCompression(options, computed, metadata);
+    emit partsSucceeded(options.inputPath, parts->outputPaths);
 }
 
-void MediaEncoder::StartCompression(const EncoderOptions& options, const ComputedOptions& computed, const Metadata& metadata)
+struct MediaEncoder::AnimatedImageSearch
 {
-    emit encodingStarted(computed.videoBitrateKbps.value_or(0), computed.audioBitrateKbps.value_or(0));
+    struct Trial
+    {
+        double scale;
+        QString path;
+        ComputedOptions computed;
+        double sizeKbps = -1; // negative until the trial succeeded
+    };
 
-    QString baseParams = BuildBaseParams(options, computed);
-    QString videoFiltersParams = BuildVideoFilterParams(options, computed);
-    QString audioFiltersParams = BuildAudioFilterParams(options, computed);
+    QTemporaryDir directory;
+    QString fileExtension;
+    QString outputPath;
+    ComputedOptions analyzed;
+    Metadata planned;
+    double low = 0;
+    double high = 1;
+    int round = 0;
+    qsizetype remaining = 0;
+    QList<Trial> trials;
+    QString lastOutput;
+};
 
+void MediaEncoder::EncodeAnimatedImage(const EncoderOptions& options)
+{
     const auto maybeFileExtension = extensionForContainer(options.container);
     if (std::holds_alternative<Message>(maybeFileExtension))
     {
@@ -53,134 +1212,545 @@ void MediaEncoder::StartCompression(const EncoderOptions& options, const Compute
         return;
     }
 
-    const QString fileExtension = std::get<QString>(maybeFileExtension);
-    QString outputPath = options.outputPath + "." + fileExtension;
+    const auto search = QSharedPointer<AnimatedImageSearch>::create();
+    search->fileExtension = std::get<QString>(maybeFileExtension);
+    search->outputPath = options.outputPath + "." + search->fileExtension;
+
+    if (!search->directory.isValid())
+    {
+        emit encodingFailed(tr("Could not prepare the trial encodes."), search->directory.errorString());
+        return;
+    }
+
+    emit encodingStarted(0, 0);
+
+    // the trials only decode what the trim keeps and what the crop leaves, so the size budget is planned for that
+    AnalyzeInput(options, false, [=, this](const ComputedOptions& analyzed)
+    {
+        search->analyzed = analyzed;
+        search->planned = plannedMetadata(options.inputMetadata, analyzed);
+
+        if (!options.sizeKbps.has_value() || !animatedImagePlanner.isScalable(options))
+        {
+            StartAnimatedImageRound(options, search, { 1 });
+            return;
+        }
+
+        // the first round brackets the estimate, later ones bisect between the closest fitting and overshooting trials
+        const double initialScale = animatedImagePlanner.initialScale(options, search->planned);
+        search->low = qMax(animatedImagePlanner.minScale, initialScale / 4);
+        search->high = qMin(1.0, initialScale * 4);
+
+        QList<double> scales;
+        const int count = animatedImagePlanner.trialsPerRound;
+        for (int i = 0; i < count; i++)
+            scales.append(search->low * std::pow(search->high / search->low, static_cast<double>(i) / (count - 1)));
+
+        StartAnimatedImageRound(options, search, scales);
+    });
+}
+
+void MediaEncoder::StartAnimatedImageRound(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search, const QList<double>& scales)
+{
+    search->round++;
+    search->remaining = scales.size();
+
+    for (const double scale : scales)
+        StartAnimatedImageTrial(options, search, scale);
+}
+
+void MediaEncoder::StartAnimatedImageTrial(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search, double scale)
+{
+    const AnimatedImagePlanner::Geometry geometry = animatedImagePlanner.geometryFor(options, search->planned, scale);
+
+    ComputedOptions computed = search->analyzed;
+    computed.outputWidth = geometry.width;
+    computed.outputHeight = geometry.height;
+    computed.fps = geometry.fps;
+
+    const qsizetype index = search->trials.size();
+    const QString trialPath = search->directory.filePath(QString("trial%1.%2").arg(index).arg(search->fileExtension));
+    search->trials.append({ .scale = scale, .path = trialPath, .computed = computed });
+
+    // palettegen and paletteuse share one graph, so the input is only decoded once
+    const QString filters = BuildVideoFilterGraph(options, computed).toString();
+    const QString graph = "[0:v]" + (filters.isEmpty() ? "" : filters + ",") + animatedImagePlanner.outputFilters(*options.videoCodec);
+
+    const QString command = QString(R"(ffmpeg %1 -i "%2" -filter_complex "%3" -map "[out]" %4 %5 -an %6 "%7" -y)")
+                                .arg(BuildInputParams(computed), options.inputPath, graph, BuildBaseParams(options, computed),
+                                     animatedImagePlanner.codecParams(*options.videoCodec), options.customArguments.value_or(""), trialPath);
 
-    const QString command = QString(R"(ffmpeg -i "%1" -c:s copy %2 %3 %4 %5 "%6" -y)")
-                                .arg(options.inputPath, baseParams, videoFiltersParams, audioFiltersParams, *options.customArguments, outputPath);
+    MemoryModel::Estimate memoryEstimate = memoryModel.EstimatePeak(search->planned, options.videoCodec);
+    memoryEstimate.formulaMb += animatedImagePlanner.bufferedFramesMb(options, search->planned, geometry);
+    memoryEstimate.peakMb += animatedImagePlanner.bufferedFramesMb(options, search->planned, geometry);
 
-    processUpdateConnection = connect(ffmpeg, &QProcess::readyRead, [metadata, this]
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryEstimate });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
     {
-        UpdateProgress(metadata.durationSeconds);
+        if (error != QProcess::FailedToStart)
+            return;
+
+        search->lastOutput = tr("Process %1").arg(QVariant::fromValue(error).toString());
+        EndAnimatedImageTrial(options, search);
     });
 
-    processFinishedConnection = connect(ffmpeg, &QProcess::finished, [=, this](const int exitCode)
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
     {
-        EndCompression(options, computed, outputPath, command, exitCode);
+        const QFileInfo trial(trialPath);
+
+        if (exitCode == 0 && trial.exists())
+            search->trials[index].sizeKbps = trial.size() / 125.0;
+        else
+            search->lastOutput = command + "\n\n" + ffmpeg->readAll();
+
+        EndAnimatedImageTrial(options, search);
     });
+}
+
+void MediaEncoder::EndAnimatedImageTrial(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search)
+{
+    search->remaining--;
+
+    const int rounds = options.sizeKbps.has_value() ? animatedImagePlanner.rounds : 1;
+    emit encodingProgressUpdate(100.0 * (search->round - 1) / rounds + 100.0 / rounds * (1 - static_cast<double>(search->remaining) / animatedImagePlanner.trialsPerRound));
+
+    if (search->remaining > 0)
+        return;
+
+    using Trial = AnimatedImageSearch::Trial;
+    const double targetKbps = options.sizeKbps.value_or(std::numeric_limits<double>::max());
+
+    const Trial* fitting = nullptr;     // largest scale that fits
+    const Trial* overshooting = nullptr; // smallest scale that does not
+    const Trial* smallest = nullptr;
+
+    for (const Trial& trial : search->trials)
+    {
+        if (trial.sizeKbps < 0)
+            continue;
 
-    ffmpeg->startCommand(command);
+        if (trial.sizeKbps <= targetKbps && (fitting == nullptr || trial.scale > fitting->scale))
+            fitting = &trial;
+
+        if (trial.sizeKbps > targetKbps && (overshooting == nullptr || trial.scale < overshooting->scale))
+            overshooting = &trial;
+
+        if (smallest == nullptr || trial.sizeKbps < smallest->sizeKbps)
+            smallest = &trial;
+    }
+
+    if (options.sizeKbps.has_value() && search->round < animatedImagePlanner.rounds && smallest != nullptr)
+    {
+        if (overshooting != nullptr)
+            search->high = overshooting->scale;
+        else // everything fits, so look further up
+            search->high = qMin(1.0, fitting->scale * 4);
+
+        if (fitting != nullptr)
+            search->low = fitting->scale;
+        else
+            search->low = qMax(animatedImagePlanner.minScale, search->high / 8);
+
+        if (search->high / search->low > 1.05 && search->high > animatedImagePlanner.minScale)
+        {
+            QList<double> scales;
+            const int count = animatedImagePlanner.trialsPerRound;
+            for (int i = 1; i <= count; i++)
+                scales.append(search->low * std::pow(search->high / search->low, static_cast<double>(i) / (count + 1)));
+
+            StartAnimatedImageRound(options, search, scales);
+            return;
+        }
+    }
+
+    // when nothing fits, the smallest attempt is the closest to what was asked
+    const Trial* best = fitting != nullptr ? fitting : smallest;
+    if (best == nullptr)
+    {
+        emit encodingFailed(parseOutput(search->lastOutput), search->lastOutput);
+        return;
+    }
+
+    QFile::remove(search->outputPath);
+    if (!QFile::rename(best->path, search->outputPath))
+    {
+        emit encodingFailed(tr("Could not move the encoded image to its destination."), search->outputPath);
+        return;
+    }
+
+    QFile media(search->outputPath);
+    emit encodingSucceeded(options, best->computed, media);
 }
 
-void MediaEncoder::UpdateProgress(double mediaDuration)
+void MediaEncoder::UpdateProgress(QProcess* ffmpeg, QString& output, double mediaDuration)
 {
     const QString line(ffmpeg->readAll());
-    const QRegularExpression regex("time=([0-9][0-9]:[0-9][0-9]:[0-9][0-9].[0-9][0-9])");
-    const QRegularExpressionMatch match = regex.match(line);
+    output += line;
+
+    const optional<double> currentDuration = parseProgressSeconds(line);
+    if (!currentDuration.has_value() || mediaDuration <= 0)
+        return;
 
+    const int progressPercent = *currentDuration * 100 / mediaDuration;
+    emit encodingProgressUpdate(progressPercent);
+}
+
+void MediaEncoder::UpdateGrowingProgress(QProcess* ffmpeg, QString& output, const EncoderOptions& options)
+{
+    const QString line(ffmpeg->readAll());
     output += line;
 
-    if (!match.hasMatch())
+    const optional<double> encodedSeconds = parseProgressSeconds(line);
+    if (!encodedSeconds.has_value())
         return;
 
-    const QTime timestamp = QTime::fromString(match.captured(1));
-    const int currentDuration = timestamp.second() + timestamp.minute() * 60 + timestamp.hour() * 3600;
-    const int progressPercent = currentDuration * 100 / mediaDuration;
+    // recordings keep about the bitrate they were probed at, so the size of the input tells how much of it is written
+    const Metadata& probed = options.inputMetadata;
+    const double writtenKb = QFileInfo(options.inputPath).size() * 0.001;
+    const double writtenSeconds = probed.sizeKbps > 0 && probed.durationSeconds > 0 ? writtenKb * probed.durationSeconds / probed.sizeKbps : 0;
 
-    emit encodingProgressUpdate(progressPercent);
+    emit growingProgressUpdate(*encodedSeconds, writtenSeconds > 0 ? qMax(writtenSeconds, *encodedSeconds) : 0);
 }
 
-void MediaEncoder::EndCompression(const EncoderOptions& options, const ComputedOptions& computed, QString outputPath, QString command, int exitCode)
+optional<double> MediaEncoder::parseProgressSeconds(const QString& line) const
+{
+    const QRegularExpression regex("time=([0-9][0-9]:[0-9][0-9]:[0-9][0-9].[0-9][0-9])");
+    const QRegularExpressionMatch match = regex.match(line);
+
+    if (!match.hasMatch())
+        return {};
+
+    const QTime timestamp = QTime::fromString(match.captured(1));
+    return timestamp.second() + timestamp.minute() * 60 + timestamp.hour() * 3600;
+}
+
+void MediaEncoder::EndCompression(const EncoderOptions& options, const ComputedOptions& computed, QString outputPath, QString command, int exitCode, const QString& output)
 {
     if (exitCode != 0)
     {
-        disconnect(processUpdateConnection);
-        disconnect(processFinishedConnection);
-
-        emit encodingFailed(parseOutput(), command + "\n\n" + output);
-        output.clear();
+        emit encodingFailed(parseOutput(output), command + "\n\n" + output);
         return;
     }
 
     QFile media(outputPath);
     if (!media.open(QIODevice::ReadOnly))
     {
-        disconnect(processUpdateConnection);
-        disconnect(processFinishedConnection);
         emit encodingFailed("Could not open the compressed media.", media.errorString());
-        output.clear();
         media.close();
         return;
     }
 
     media.close();
-    disconnect(processUpdateConnection);
-    disconnect(processFinishedConnection);
+    RecordOvershoot(options, computed, outputSizeKb(options, outputPath));
+
     emit encodingSucceeded(options, computed, media);
-    output.clear();
+}
+
+void MediaEncoder::EndRenditions(
+    const std::vector<EncoderOptions>& renditions, const std::vector<ComputedOptions>& computed, const QStringList& outputPaths, QString command, int exitCode, const QString& output
+)
+{
+    if (exitCode != 0)
+    {
+        emit encodingFailed(parseOutput(output), command + "\n\n" + output);
+        return;
+    }
+
+    for (size_t i = 0; i < renditions.size(); i++)
+    {
+        const QFileInfo media(outputPaths[i]);
+        if (!media.exists())
+        {
+            emit encodingFailed(tr("Could not open the compressed media."), outputPaths[i]);
+            return;
+        }
+
+        RecordOvershoot(renditions[i], computed[i], media.size() / 125.0);
+    }
+
+    emit renditionsSucceeded(renditions.front().inputPath, outputPaths);
+}
+
+void MediaEncoder::RecordOvershoot(const EncoderOptions& options, const ComputedOptions& computed, double actualKbps)
+{
+    // a bitrate pinned to one of its bounds says nothing about how accurately the encoder hits its target
+    const bool isBitrateBounded = options.videoCodec.has_value()
+                                      ? computed.videoBitrateKbps.value_or(0) <= options.minVideoBitrateKbps
+                                      : computed.audioBitrateKbps.value_or(0) <= options.minAudioBitrateKbps || computed.audioBitrateKbps.value_or(0) >= options.maxAudioBitrateKbps;
+
+    if (computed.sizeCorrection.has_value() && !isBitrateBounded)
+        overshootModel.Record(*computed.sizeCorrection, computed.intendedSizeKbps.value_or(*options.sizeKbps * (1.0 - options.overshootCorrectionPercent)), actualKbps);
+}
+
+QString MediaEncoder::BuildCompressionCommand(
+    const EncoderOptions& options, const ComputedOptions& computed, const QString& outputPath, MemoryModel::Estimate& estimate
+) const
+{
+    const QString baseParams = BuildBaseParams(options, computed);
+    const QString videoFiltersParams = BuildVideoFilterParams(options, computed);
+    const QString audioFiltersParams = BuildAudioFilterParams(options, computed);
+    const QString memoryLimitParams = BuildMemoryLimitParams(options, estimate);
+    const QString streamingParams = BuildStreamingParams(options, outputPath);
+    const QString inputParams = QStringList { BuildFollowParams(options), BuildInputParams(computed) }.join(' ').trimmed();
+
+    return QString(R"(ffmpeg %1 -i "%2" -c:s copy %3 %4 %5 %6 %7 %8 "%9" -y)")
+        .arg(inputParams, options.inputPath, baseParams, memoryLimitParams, videoFiltersParams, audioFiltersParams, streamingParams, *options.customArguments, outputPath);
+}
+
+QString MediaEncoder::BuildStreamingParams(const EncoderOptions& options, const QString& outputPath) const
+{
+    if (!options.streamingFormat.has_value())
+        return "";
+
+    // keyframes on segment boundaries make every segment start cleanly; copied video keeps the keyframes it has
+    const bool isReencoded = options.videoCodec.has_value() && options.videoCodec->libraryName != "copy";
+    const QString keyframeParam = isReencoded ? QString(R"(-force_key_frames "expr:gte(t,n_forced*%1)")").arg(segmentSeconds) : "";
+    const QString name = QFileInfo(outputPath).completeBaseName();
+
+    QString formatParams;
+    switch (*options.streamingFormat)
+    {
+    case StreamingFormat::FragmentedMp4:
+        formatParams = "-f mp4 -movflags +frag_keyframe+empty_moov+default_base_moof";
+        break;
+    case StreamingFormat::Hls:
+        // segments are written under a temporary name and renamed once complete, so that a listed segment is whole
+        formatParams = QString(R"(-f hls -hls_time %1 -hls_playlist_type event -hls_segment_type fmp4 -hls_flags independent_segments+temp_file )"
+                               R"(-hls_fmp4_init_filename "%2_init.mp4" -hls_segment_filename "%3")")
+                           .arg(QString::number(segmentSeconds), name, QFileInfo(outputPath).dir().filePath(name + "_%05d.m4s"));
+        break;
+    case StreamingFormat::Dash:
+        formatParams = QString(R"(-f dash -seg_duration %1 -use_template 1 -use_timeline 1 )"
+                               R"(-init_seg_name "%2" -media_seg_name "%3")")
+                           .arg(QString::number(segmentSeconds), name + "_init_$RepresentationID$.$ext$", name + "_$RepresentationID$_$Number%05d$.$ext$");
+        break;
+    }
+
+    return keyframeParam.isEmpty() ? formatParams : keyframeParam + " " + formatParams;
+}
+
+QString MediaEncoder::BuildFollowParams(const EncoderOptions& options) const
+{
+    if (!options.followIdleSeconds.has_value())
+        return "";
+
+    // the file protocol waits for more data at the end of the input, and gives up once none came for the timeout,
+    // which the demuxer then takes as the end of the input
+    const qint64 idleMicroseconds = qRound64(*options.followIdleSeconds * 1000000);
+    return QString("-follow 1 -rw_timeout %1").arg(idleMicroseconds);
+}
+
+QString MediaEncoder::BuildInputParams(const ComputedOptions& computed) const
+{
+    if (!computed.trim.has_value())
+        return "";
+
+    // seeking on the input skips decoding what is trimmed, instead of decoding and discarding it
+    return QString("-ss %1 -t %2").arg(QString::number(computed.trim->startSeconds), QString::number(computed.trim->durationSeconds));
 }
 
 QString MediaEncoder::BuildBaseParams(const EncoderOptions& options, const ComputedOptions& computed) const
 {
     const QString videoCodecParam = options.videoCodec.has_value() ? "-c:v " + options.videoCodec->libraryName : "-vn";
     const QString audioCodecParam = options.audioCodec.has_value() ? "-c:a " + options.audioCodec->libraryName : "-an";
-    const QString videoBitrateParam = options.sizeKbps.has_value() ? "-b:v " + QString::number(*computed.videoBitrateKbps) + "k" : "";
+    const QString videoBitrateParam = computed.videoBitrateKbps.has_value() ? "-b:v " + QString::number(*computed.videoBitrateKbps) + "k" : "";
     const QString audioBitrateParam = computed.audioBitrateKbps.has_value() ? "-b:a " + QString::number(*computed.audioBitrateKbps) + "k" : "";
     const QString audioChannelsParam = options.audioChannelsCount.has_value() ? "-ac " + QString::number(*options.audioChannelsCount) : "";
-    const QString formatParam = QString("-f %1").arg(options.container.formatName);
+    const QString qualityParam = BuildConstantQualityParams(options);
+    const QString speedParam = BuildSpeedParams(options);
+    // streaming outputs pick their muxer along with how it segments, see BuildStreamingParams
+    const QString formatParam = options.streamingFormat.has_value() ? "" : QString("-f %1").arg(options.container.formatName);
+    // the muxer would otherwise duplicate dropped frames back to a constant rate
+    const QString frameRateModeParam = options.decimate && options.videoCodec.has_value() ? "-fps_mode vfr" : "";
 
-    QStringList params { videoCodecParam, audioCodecParam, videoBitrateParam,
-                         audioBitrateParam, audioChannelsParam, formatParam };
+    QStringList params { videoCodecParam, audioCodecParam, videoBitrateParam, qualityParam,
+                         audioBitrateParam, audioChannelsParam, speedParam, frameRateModeParam, formatParam };
     params.removeAll({});
 
     return params.join(" ");
 }
 
+QString MediaEncoder::BuildConstantQualityParams(const EncoderOptions& options) const
+{
+    if (!options.videoCodec.has_value() || !options.constantQualityPercent.has_value())
+        return "";
+
+    const QString& codec = options.videoCodec->libraryName;
+    const double quality = *options.constantQualityPercent / 100.0;
+
+    // maps the quality onto a codec scale where lower values look better
+    const auto scale = [quality](int best, int worst)
+    {
+        return QString::number(qRound(worst - quality * (worst - best)));
+    };
+
+    if (codec.startsWith("libx264") || codec == "libx265")
+        return "-crf " + scale(0, 51);
+
+    // constant quality mode requires the target bitrate to be unset
+    if (codec == "libaom-av1" || codec.startsWith("libvpx"))
+        return "-crf " + scale(0, 63) + " -b:v 0";
+
+    if (codec == "libsvtav1")
+        return "-crf " + scale(1, 63);
+
+    if (codec.endsWith("_nvenc"))
+        return "-rc vbr -cq " + scale(1, 51) + " -b:v 0";
+
+    if (codec.endsWith("_qsv"))
+        return "-global_quality " + scale(1, 51);
+
+    if (codec.endsWith("_amf"))
+    {
+        const QString qp = scale(0, 51);
+        return QString("-rc cqp -qp_i %1 -qp_p %1 -qp_b %1").arg(qp);
+    }
+
+    if (codec.startsWith("libwebp"))
+        return "-quality " + QString::number(*options.constantQualityPercent);
+
+    if (codec == "mpeg4" || codec == "libxvid" || codec == "mjpeg" || codec.startsWith("msmpeg4"))
+        return "-q:v " + scale(1, 31);
+
+    return "";
+}
+
+QString MediaEncoder::BuildSpeedParams(const EncoderOptions& options) const
+{
+    if (!options.videoCodec.has_value() || !options.speedTier.has_value())
+        return "";
+
+    const QString& codec = options.videoCodec->libraryName;
+    const auto tier = static_cast<qsizetype>(*options.speedTier);
+
+    // one value per tier, from fastest to archival
+    const auto pick = [tier](const QStringList& values)
+    {
+        return values[tier];
+    };
+
+    if (codec.startsWith("libx264") || codec == "libx265")
+        return "-preset " + pick({ "ultrafast", "veryfast", "medium", "slow", "veryslow" });
+
+    if (codec == "libaom-av1")
+        return "-cpu-used " + pick({ "8", "6", "4", "2", "0" });
+
+    if (codec == "libsvtav1")
+        return "-preset " + pick({ "12", "10", "8", "5", "2" });
+
+    if (codec.startsWith("libvpx"))
+        return pick({ "-deadline realtime -cpu-used 8", "-deadline good -cpu-used 4", "-deadline good -cpu-used 2",
+                      "-deadline good -cpu-used 1", "-deadline best -cpu-used 0" });
+
+    if (codec.endsWith("_nvenc"))
+        return "-preset " + pick({ "p1", "p3", "p4", "p6", "p7" });
+
+    if (codec.endsWith("_qsv"))
+        return "-preset " + pick({ "veryfast", "faster", "medium", "slower", "veryslow" });
+
+    if (codec.endsWith("_amf"))
+        return "-quality " + pick({ "speed", "speed", "balanced", "quality", "quality" });
+
+    if (codec.startsWith("libwebp"))
+        return "-compression_level " + pick({ "0", "2", "4", "5", "6" });
+
+    return "";
+}
+
+QString MediaEncoder::BuildMemoryLimitParams(const EncoderOptions& options, MemoryModel::Estimate& estimate) const
+{
+    if (!options.videoCodec.has_value() || !scheduler.limitsEncoderMemory() || scheduler.fitsBudgetAlone(estimate))
+        return "";
+
+    estimate = memoryModel.EstimatePeak(options.inputMetadata, options.videoCodec, true);
+    return memoryModel.MemoryLimitParams(*options.videoCodec);
+}
+
 QString MediaEncoder::BuildVideoFilterParams(const EncoderOptions& options, const ComputedOptions& computed) const
 {
-    QString aspectRatioFilter;
-    QString scaleFilter;
-    if (options.outputWidth.has_value() && options.outputHeight.has_value())
+    const QString filters = BuildVideoFilterGraph(options, computed).toString();
+
+    return filters.isEmpty() ? "" : "-filter:v " + filters;
+}
+
+FilterGraph MediaEncoder::BuildVideoFilterGraph(const EncoderOptions& options, const ComputedOptions& computed) const
+{
+    const Metadata& metadata = options.inputMetadata;
+    const bool hasDimensions = metadata.width > 0 && metadata.height > 0;
+
+    FilterGraph graph({
+        .width = metadata.width,
+        .height = metadata.height,
+        .frameRate = metadata.frameRate,
+        .sampleAspectRatio = hasDimensions ? metadata.aspectRatioX / metadata.aspectRatioY / (metadata.width / metadata.height) : 1,
+    });
+
+    // before anything else, so that no filter spends time on the bars
+    if (computed.crop.has_value())
+    {
+        graph.crop(computed.crop->width(), computed.crop->height(), computed.crop->x(), computed.crop->y());
+    }
+
+    if (computed.outputWidth.has_value() && computed.outputHeight.has_value())
+    {
+        graph.scale(*computed.outputWidth, *computed.outputHeight);
+    }
+    else if (options.outputWidth.has_value() && options.outputHeight.has_value())
     {
-        scaleFilter = QString("scale=%1:%2").arg(QString::number(*options.outputWidth), QString::number(*options.outputHeight));
-        aspectRatioFilter = "setsar=1/1";
+        graph.scale(*options.outputWidth, *options.outputHeight);
+
+        if (!options.aspectRatio.has_value())
+            graph.setSar(1, 1);
     }
     else if (options.outputWidth.has_value())
     {
-        scaleFilter = QString("scale=%1:-2").arg(QString::number(*options.outputWidth));
+        graph.scale(*options.outputWidth, -2);
     }
     else if (options.outputHeight.has_value())
     {
-        scaleFilter = QString("scale=-1:%1").arg(QString::number(*options.outputHeight));
+        graph.scale(-1, *options.outputHeight);
     }
 
     if (options.aspectRatio.has_value())
     {
-        aspectRatioFilter = QString("setsar=%1/%2")
-                                .arg(QString::number(options.aspectRatio->y()), QString::number(options.aspectRatio->x()));
+        graph.setSar(options.aspectRatio->y(), options.aspectRatio->x());
     }
 
-    QString speedFilter;
-    double fps = *options.fps;
+    double fps = options.fps.value_or(0);
     if (options.speed.has_value())
     {
-        speedFilter = QString("setpts=%1*PTS").arg(QString::number(1.0 / *options.speed));
+        graph.setPts(1.0 / *options.speed);
         fps *= *options.speed;
     }
 
-    QString fpsFilter;
     if (options.fps.has_value())
     {
-        fpsFilter = "fps=" + QString::number(fps);
+        graph.fps(fps);
+    }
+    else if (computed.fps.has_value())
+    {
+        graph.fps(*computed.fps);
     }
 
-    QStringList videoFilters { scaleFilter, aspectRatioFilter, speedFilter, fpsFilter };
-    videoFilters.removeAll({});
+    // last, so that a lowered frame rate is decimated rather than duplicated back up
+    if (options.decimate)
+    {
+        graph.decimate(decimationAnalyzer.maxDroppedFrames(graph.output().frameRate), computed.keptFrameFraction.value_or(1));
+    }
 
-    return videoFilters.empty() ? "" : "-filter:v " + videoFilters.join(',');
+    return graph;
 }
 
 QString MediaEncoder::BuildAudioFilterParams(const EncoderOptions& options, const ComputedOptions& computed) const
+{
+    const QString filters = BuildAudioFilters(options, computed);
+
+    return filters.isEmpty() ? "" : "-filter:a " + filters;
+}
+
+QString MediaEncoder::BuildAudioFilters(const EncoderOptions& options, const ComputedOptions& computed) const
 {
     QString audioSpeedFilter;
     if (options.speed.has_value())
@@ -188,48 +1758,60 @@ QString MediaEncoder::BuildAudioFilterParams(const EncoderOptions& options, cons
         audioSpeedFilter = "atempo=" + QString::number(*options.speed);
     }
 
-    QStringList audioFilters { audioSpeedFilter };
+    QString loudnessFilter;
+    if (options.loudnessLufs.has_value() && computed.loudness.has_value())
+    {
+        loudnessFilter = loudnessAnalyzer.normalizationFilter(*computed.loudness, *options.loudnessLufs);
+    }
+
+    QStringList audioFilters { audioSpeedFilter, loudnessFilter };
     audioFilters.removeAll({});
 
-    return audioFilters.empty() ? "" : "-filter:a " + audioFilters.join(',');
+    return audioFilters.join(',');
 }
 
 QString MediaEncoder::getAvailableFormats() const
 {
-    ffmpeg->startCommand("ffmpeg -encoders");
-    ffmpeg->waitForFinished();
-    return ffmpeg->readAllStandardOutput();
+    QProcess ffmpeg;
+    ffmpeg.startCommand("ffmpeg -encoders");
+    ffmpeg.waitForFinished();
+    return ffmpeg.readAllStandardOutput();
 }
 
 bool MediaEncoder::computeAudioBitrate(const EncoderOptions& options, ComputedOptions& computed) const
 {
-    double audioBitrateKbps = qMax(options.minAudioBitrateKbps, options.audioQualityPercent.value_or(1) * options.maxAudioBitrateKbps);
-    // TODO: Using the strategy pattern, specialize certain codecs to use different bitrate formulas
+    const RateControlStrategy& strategy = rateControl.forCodec(*options.audioCodec);
+    const int channels = options.audioChannelsCount.value_or(2);
+
+    const double minBitrateKbps = qMax(options.minAudioBitrateKbps, strategy.minBitrateKbps(channels));
+    const double maxBitrateKbps = qMin(options.maxAudioBitrateKbps, strategy.maxBitrateKbps(channels));
+
+    // the quality scale tops out where the codec becomes transparent rather than at the absolute maximum
+    double audioBitrateKbps = qMax(minBitrateKbps, options.audioQualityPercent.value_or(1) * qMin(maxBitrateKbps, strategy.transparentBitrateKbps(channels)));
+
+    // audio-only outputs spend the whole target size on audio
+    if (!options.videoCodec.has_value() && options.sizeKbps.has_value())
+    {
+        const double durationSeconds = plannedMetadata(options.inputMetadata, computed).durationSeconds;
+        const double availableKbps = (*options.sizeKbps - containerHeaderKb) / durationSeconds - strategy.containerOverheadKbps(options.container);
+        const double correction = computed.sizeCorrection.has_value() ? computed.sizeCorrection->factor : 1;
+        const double bitrateKbps = strategy.bitrateForTargetKbps(availableKbps) / correction * (1.0 - options.overshootCorrectionPercent);
 
-    computed.audioBitrateKbps = audioBitrateKbps;
+        audioBitrateKbps = qBound(minBitrateKbps, bitrateKbps, maxBitrateKbps);
+    }
+
+    computed.audioBitrateKbps = strategy.supportedBitrateKbps(audioBitrateKbps);
     return true;
 }
 
-double MediaEncoder::computePixelRatio(const EncoderOptions& options, const Metadata& metadata) const
+double MediaEncoder::computePixelRatio(const EncoderOptions& options, const ComputedOptions& computed, const Metadata& metadata) const
 {
     double pixelRatio = 1;
-    int outputWidth;
-    int outputHeight;
-
-    const long inputPixelCount = metadata.width * metadata.height;
-
-    if (options.outputWidth.has_value())
-    {
-        outputHeight = *options.outputHeight;
-        outputWidth = outputHeight * metadata.aspectRatioX / metadata.aspectRatioY;
-    }
-    else
-    {
-        outputWidth = *options.outputWidth;
-        outputHeight = outputWidth * metadata.aspectRatioX / metadata.aspectRatioY;
-    }
 
-    const double outputPixelCount = outputWidth * outputHeight;
+    // black bars take next to no bits, so cropping them does not lower what the picture itself needs
+    const double inputPixelCount = computed.crop.has_value() ? computed.crop->width() * computed.crop->height() : metadata.width * metadata.height;
+    const FilterGraph::StreamState output = BuildVideoFilterGraph(options, computed).output();
+    const double outputPixelCount = output.width * output.height;
 
     // TODO: Add option to enable bitrate compensation even when upscaling (will result in bigger files)
     if (outputPixelCount > 0 && outputPixelCount < inputPixelCount)
@@ -238,6 +1820,47 @@ double MediaEncoder::computePixelRatio(const EncoderOptions& options, const Meta
     return pixelRatio;
 }
 
+std::variant<QString, Message> MediaEncoder::PrepareOutputPath(const EncoderOptions& options, const QString& stemPath) const
+{
+    if (!options.streamingFormat.has_value())
+    {
+        const auto maybeFileExtension = extensionForContainer(options.container);
+        if (std::holds_alternative<Message>(maybeFileExtension))
+            return std::get<Message>(maybeFileExtension);
+
+        return stemPath + "." + std::get<QString>(maybeFileExtension);
+    }
+
+    if (*options.streamingFormat == StreamingFormat::FragmentedMp4)
+        return stemPath + ".mp4";
+
+    // segments get a folder of their own, named after the output
+    const QFileInfo stem(stemPath);
+    QDir directory(stemPath);
+    if (!directory.mkpath("."))
+        return Message(Severity::Critical, tr("Failed to create the output folder"), tr("Could not create the folder %1 for the segments.").arg(stemPath));
+
+    // segments left by an earlier, longer encode would otherwise be counted and served along with the new ones
+    for (const QString& fileName : directory.entryList({ stem.fileName() + "_*" }, QDir::Files))
+        directory.remove(fileName);
+
+    const QString extension = *options.streamingFormat == StreamingFormat::Hls ? "m3u8" : "mpd";
+    return directory.filePath(stem.fileName() + "." + extension);
+}
+
+double MediaEncoder::outputSizeKb(const EncoderOptions& options, const QString& outputPath)
+{
+    const QFileInfo output(outputPath);
+    if (!options.streamingFormat.has_value() || *options.streamingFormat == StreamingFormat::FragmentedMp4)
+        return output.size() / 125.0;
+
+    qint64 sizeBytes = 0;
+    for (const QFileInfo& file : output.dir().entryInfoList({ output.completeBaseName() + "*" }, QDir::Files))
+        sizeBytes += file.size();
+
+    return sizeBytes / 125.0;
+}
+
 std::variant<QString, Message> MediaEncoder::extensionForContainer(const Container& container) const
 {
     QProcess process;
@@ -269,17 +1892,75 @@ std::variant<QString, Message> MediaEncoder::extensionForContainer(const Contain
     return extensions.first().trimmed();
 }
 
-void MediaEncoder::ComputeVideoBitrate(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata) const
+void MediaEncoder::ComputeVideoBitrate(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata, double pixelRatio) const
+{
+    const RateControlStrategy& strategy = rateControl.forCodec(*options.videoCodec);
+    const double frameRate = BuildVideoFilterGraph(options, computed).output().frameRate;
+
+    double audioBitrateKbps = 0;
+    if (options.audioCodec.has_value() && computed.audioBitrateKbps.has_value())
+    {
+        const RateControlStrategy& audioStrategy = rateControl.forCodec(*options.audioCodec);
+        audioBitrateKbps = *computed.audioBitrateKbps * (1 + audioStrategy.overshootFraction()) + audioStrategy.containerOverheadKbps(options.container);
+    }
+
+    const double availableKbps = (*options.sizeKbps - containerHeaderKb) / metadata.durationSeconds - audioBitrateKbps - strategy.containerOverheadKbps(options.container, frameRate);
+    const double correction = computed.sizeCorrection.has_value() ? computed.sizeCorrection->factor : 1;
+    const double bitrateKbps = strategy.bitrateForTargetKbps(availableKbps) / correction * (1.0 - options.overshootCorrectionPercent);
+
+    computed.videoBitrateKbps = qMax(qMax(options.minVideoBitrateKbps, strategy.minBitrateKbps(0)), pixelRatio * bitrateKbps);
+
+    // compensating for fewer pixels spends less than the target on purpose, which is no overshoot to learn from
+    const double compensatedKbps = (1 - pixelRatio) * qMax(0.0, availableKbps) * metadata.durationSeconds;
+    computed.intendedSizeKbps = (*options.sizeKbps - compensatedKbps) * (1.0 - options.overshootCorrectionPercent);
+}
+
+void MediaEncoder::ComputeOutputResolution(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata) const
 {
-    const double audioBitrateKbps = computed.audioBitrateKbps.value_or(0);
+    const bool hasCustomGeometry = options.outputWidth.has_value() || options.outputHeight.has_value() || options.fps.has_value();
+
+    if (!options.autoResolution || hasCustomGeometry || options.videoCodec->libraryName == "copy" || !computed.videoBitrateKbps.has_value())
+        return;
+
+    const optional<ResolutionLadder::Choice> choice = resolutionLadder.choose(metadata, *options.videoCodec, *computed.videoBitrateKbps, options.speed.value_or(1));
+    if (!choice.has_value())
+        return;
+
+    if (choice->height < metadata.height)
+    {
+        computed.outputWidth = choice->width;
+        computed.outputHeight = choice->height;
+    }
+
+    if (choice->frameRate < metadata.frameRate * options.speed.value_or(1))
+        computed.fps = choice->frameRate;
+}
+
+Metadata MediaEncoder::plannedMetadata(const Metadata& metadata, const ComputedOptions& computed) const
+{
+    Metadata planned = metadata;
+
+    if (computed.crop.has_value())
+    {
+        planned.width = computed.crop->width();
+        planned.height = computed.crop->height();
+
+        // the display aspect ratio follows the cropped picture, with the pixels keeping their shape
+        planned.aspectRatioX = metadata.aspectRatioX * computed.crop->width() / metadata.width;
+        planned.aspectRatioY = metadata.aspectRatioY * computed.crop->height() / metadata.height;
+    }
+
+    // every bit goes to the frames that are left, so they can afford more pixels
+    if (computed.keptFrameFraction.has_value())
+        planned.frameRate = metadata.frameRate * *computed.keptFrameFraction;
 
-    const double pixelRatio = computePixelRatio(options, metadata);
-    const double bitrateKbps = *options.sizeKbps / metadata.durationSeconds * (1.0 - options.overshootCorrectionPercent);
+    if (computed.trim.has_value())
+        planned.durationSeconds = computed.trim->durationSeconds;
 
-    computed.videoBitrateKbps = qMax(options.minVideoBitrateKbps, pixelRatio * (bitrateKbps - audioBitrateKbps));
+    return planned;
 }
 
-QString MediaEncoder::parseOutput() const
+QString MediaEncoder::parseOutput(const QString& output) const
 {
     QStringList split = output.split("Press [q] to stop, [?] for help");
     if (split.length() == 1)
@@ -4,7 +4,24 @@
 #include "core/formats/codec.hpp"
 #include "core/formats/container.hpp"
 #include "core/formats/metadata.hpp"
+#include "animated_image.hpp"
+#include "bitrate_ladder.hpp"
+#include "crop_detector.hpp"
+#include "decimation_analyzer.hpp"
+#include "duplicate_finder.hpp"
 #include "encoder_options.hpp"
+#include "filter_graph.hpp"
+#include "image_converter.hpp"
+#include "job_scheduler.hpp"
+#include "keyframe_index.hpp"
+#include "loudness_analyzer.hpp"
+#include "memory_model.hpp"
+#include "overshoot_model.hpp"
+#include "rate_control.hpp"
+#include "resolution_ladder.hpp"
+#include "scene_cut_detector.hpp"
+#include "smart_cut.hpp"
+#include "trim_analyzer.hpp"
 
 #include <QDir>
 #include <QEventLoop>
@@ -12,6 +29,11 @@
 #include <QObject>
 #include <QPoint>
 #include <QProcess>
+#include <QRect>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <functional>
+#include <vector>
 
 struct Message;
 using std::optional;
@@ -21,50 +43,182 @@ class MediaEncoder final : public QObject
     Q_OBJECT
 
 public:
-    explicit MediaEncoder();
+    explicit MediaEncoder(
+        JobScheduler& scheduler, MemoryModel& memoryModel, RateControlRegistry& rateControl, OvershootModel& overshootModel, ImageConverter& imageConverter,
+        LoudnessAnalyzer& loudnessAnalyzer, CropDetector& cropDetector, DecimationAnalyzer& decimationAnalyzer,
+        TrimAnalyzer& trimAnalyzer, DuplicateFinder& duplicateFinder, KeyframeIndex& keyframeIndex, SceneCutDetector& sceneCutDetector
+    );
 
     struct ComputedOptions
     {
         optional<double> videoBitrateKbps;
         optional<double> audioBitrateKbps;
+        optional<int> outputWidth;
+        optional<int> outputHeight;
+        optional<double> fps;
+        optional<OvershootModel::Correction> sizeCorrection;
+        optional<double> intendedSizeKbps; // the size target, less what is left unspent on purpose
+        optional<LoudnessAnalyzer::Measurement> loudness;
+        optional<QRect> crop;
+        optional<double> keptFrameFraction;
+        optional<TrimAnalyzer::Trim> trim;
     };
 
     void Encode(const EncoderOptions& options);
+    //! Encodes a few seconds of the input from a point in it, with the bitrates planned for the whole of it, to tell
+    //! how the full encode would turn out. Runs ahead of anything queued.
+    void EncodePreview(const EncoderOptions& options, double startSeconds);
+    //! Encodes several outputs of the same input with a single FFmpeg process, decoding the input only once.
+    void EncodeRenditions(const std::vector<EncoderOptions>& renditions);
+    //! Probes the input to pick the renditions worth encoding at its resolution and below, see BitrateLadder.
+    void OptimizeLadder(const EncoderOptions& options);
+    //! Converts a batch of still images in-process, see ImageConverter. Copies of the same picture are converted once,
+    //! see DuplicateFinder.
+    void ConvertImages(const std::vector<EncoderOptions>& images);
+    //! Starts the loudness analysis of an input early, so that it is cached by the time it is encoded.
+    void MeasureLoudnessAhead(const QString& inputPath);
+    //! Starts indexing the keyframes of an input early, so that cutting or splitting it does not wait for a full scan.
+    void IndexKeyframesAhead(const QString& inputPath);
+    //! Size of an output, counting every segment of a segmented one.
+    [[nodiscard]] static double outputSizeKb(const EncoderOptions& options, const QString& outputPath);
+    //! Whether the options can be applied without FFmpeg, provided the input is a still image.
+    [[nodiscard]] bool isInProcessImage(const EncoderOptions& options) const;
     QString getAvailableFormats() const;
 
 signals:
     void encodingStarted(double videoBitrateKbps, double audioBitrateKbps);
     void encodingSucceeded(const EncoderOptions& options, const ComputedOptions& computed, QFile& output);
+    void previewEncoded(const QString& outputPath, double projectedSizeKbps, double projectedSeconds);
+    void renditionsSucceeded(const QString& inputPath, const QStringList& outputPaths);
+    void partsSucceeded(const QString& inputPath, const QStringList& outputPaths);
+    //! Segments of a streaming output that are complete and listed in its playlist, while it is still encoded.
+    void segmentsWritten(const QString& playlistPath, qsizetype count);
+    void ladderOptimized(const std::vector<EncoderOptions>& rungs);
+    void imagesConverted(const QList<ImageConverter::Result>& results);
     void encodingProgressUpdate(double progressPercent);
+    //! Progress through an input that is still being written, 0 seconds written when it cannot be told.
+    void growingProgressUpdate(double encodedSeconds, double writtenSeconds);
     void encodingFailed(QString error, QString errorDetails = "");
 
 private:
     const bool IS_WINDOWS = QSysInfo::kernelType() == "winnt";
 
+    [[nodiscard]] optional<ComputedOptions> ComputeOptions(const EncoderOptions& options, const ComputedOptions& analyzed = {}) const;
+    //! Runs the analysis passes the options call for concurrently, then continues with their results. Interactive
+    //! passes run ahead of anything queued.
+    void AnalyzeInput(const EncoderOptions& options, bool isInteractive, const std::function<void(const ComputedOptions&)>& next);
     void StartCompression(const EncoderOptions& options, const ComputedOptions& computedOptions, const Metadata& metadata);
-    void UpdateProgress(double mediaDuration);
+    void StartPreview(const EncoderOptions& options, const ComputedOptions& computed, double plannedSeconds, double startSeconds);
+    void StartRenditions(const std::vector<EncoderOptions>& renditions, const std::vector<ComputedOptions>& computed);
+    void UpdateProgress(QProcess* ffmpeg, QString& output, double mediaDuration);
+    void UpdateGrowingProgress(QProcess* ffmpeg, QString& output, const EncoderOptions& options);
+    void CountSegments(const EncoderOptions& options, const QString& playlistPath, const QString& output, qsizetype& opened);
+    //! How far into its output an FFmpeg process is, from the last progress line it printed.
+    [[nodiscard]] optional<double> parseProgressSeconds(const QString& line) const;
     void EndCompression(
-        const EncoderOptions& options, const ComputedOptions& computed, QString outputPath, QString command, int exitCode
+        const EncoderOptions& options, const ComputedOptions& computed, QString outputPath, QString command, int exitCode, const QString& output
     );
-
+    void EndRenditions(
+        const std::vector<EncoderOptions>& renditions, const std::vector<ComputedOptions>& computed, const QStringList& outputPaths, QString command, int exitCode,
+        const QString& output
+    );
+    void RecordOvershoot(const EncoderOptions& options, const ComputedOptions& computed, double actualKbps);
+
+    struct LadderProbes;
+    void StartLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes, qsizetype index);
+    void ScoreLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes, qsizetype index);
+    void EndLadderProbe(const EncoderOptions& options, const QSharedPointer<LadderProbes>& probes);
+
+    struct SmartCut;
+    void EncodeSmartCut(const EncoderOptions& options);
+    void StartSmartCutSegment(const EncoderOptions& options, const QSharedPointer<SmartCut>& cut, const SmartCutPlanner::Segment& segment, qsizetype index);
+    void EndSmartCutSegment(const EncoderOptions& options, const QSharedPointer<SmartCut>& cut);
+
+    struct Parts;
+    void EncodeParts(const EncoderOptions& options);
+    //! Analyzes the input and splits it into parts that each fit the desired size, then continues with them.
+    void PlanParts(
+        const EncoderOptions& options, bool isInteractive, const std::function<void(const ComputedOptions&, const QList<TrimAnalyzer::Trim>&)>& next
+    );
+    void StartParts(const EncoderOptions& options, const ComputedOptions& analyzed, const QList<TrimAnalyzer::Trim>& trims);
+    void EndPart(const EncoderOptions& options, const QSharedPointer<Parts>& parts);
+    //! The fewest keyframe-aligned parts of the kept range that each fit the target size at a watchable bitrate,
+    //! joined at scene cuts where there is one close by. Empty when even the most parts allowed would not fit.
+    [[nodiscard]] QList<TrimAnalyzer::Trim> partsFor(
+        const EncoderOptions& options, const ComputedOptions& analyzed, const KeyframeIndex::Map& keyframes, const QList<double>& sceneCuts
+    ) const;
+    [[nodiscard]] bool fitsPart(const EncoderOptions& options, const ComputedOptions& analyzed, const TrimAnalyzer::Trim& part) const;
+
+    struct AnimatedImageSearch;
+    void EncodeAnimatedImage(const EncoderOptions& options);
+    void StartAnimatedImageRound(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search, const QList<double>& scales);
+    void StartAnimatedImageTrial(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search, double scale);
+    void EndAnimatedImageTrial(const EncoderOptions& options, const QSharedPointer<AnimatedImageSearch>& search);
+
+    //! Whether the output keeps any sound, which animated images have no room for.
+    [[nodiscard]] bool encodesAudio(const EncoderOptions& options) const;
+    [[nodiscard]] bool needsLoudness(const EncoderOptions& options) const;
+    [[nodiscard]] bool needsCrop(const EncoderOptions& options) const;
+    [[nodiscard]] bool needsDecimation(const EncoderOptions& options) const;
+    [[nodiscard]] optional<TrimAnalyzer::Trim> manualTrim(const EncoderOptions& options) const;
+    [[nodiscard]] ImageConverter::Job imageJobFor(const EncoderOptions& options) const;
+
+    //! The whole FFmpeg command of a single-output encode, adjusting the memory estimate to its limits.
+    [[nodiscard]] QString BuildCompressionCommand(
+        const EncoderOptions& options, const ComputedOptions& computed, const QString& outputPath, MemoryModel::Estimate& estimate
+    ) const;
+    [[nodiscard]] QString BuildStreamingParams(const EncoderOptions& options, const QString& outputPath) const;
+    [[nodiscard]] QString BuildFollowParams(const EncoderOptions& options) const;
+    [[nodiscard]] QString BuildInputParams(const ComputedOptions& computed) const;
     [[nodiscard]] QString BuildBaseParams(const EncoderOptions& options, const ComputedOptions& computed) const;
-    [[nodiscard]] QString BuildVideoFilterParams(const EncoderOptions& options, [[maybe_unused]] const ComputedOptions& computed) const;
+    [[nodiscard]] QString BuildConstantQualityParams(const EncoderOptions& options) const;
+    [[nodiscard]] QString BuildSpeedParams(const EncoderOptions& options) const;
+    [[nodiscard]] QString BuildMemoryLimitParams(const EncoderOptions& options, MemoryModel::Estimate& estimate) const;
+    [[nodiscard]] QString BuildVideoFilterParams(const EncoderOptions& options, const ComputedOptions& computed) const;
+    [[nodiscard]] FilterGraph BuildVideoFilterGraph(const EncoderOptions& options, const ComputedOptions& computed) const;
     [[nodiscard]] QString BuildAudioFilterParams(const EncoderOptions& options, const ComputedOptions& computed) const;
+    [[nodiscard]] QString BuildAudioFilters(const EncoderOptions& options, const ComputedOptions& computed) const;
 
-    void ComputeVideoBitrate(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata) const;
+    void ComputeVideoBitrate(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata, double pixelRatio) const;
+    void ComputeOutputResolution(const EncoderOptions& options, ComputedOptions& computed, const Metadata& metadata) const;
     bool computeAudioBitrate(const EncoderOptions& options, ComputedOptions& computed) const;
-    double computePixelRatio(const EncoderOptions& options, const Metadata& metadata) const;
+    double computePixelRatio(const EncoderOptions& options, const ComputedOptions& computed, const Metadata& metadata) const;
+    //! The input as the planner should see it, once trimmed, cropped and decimated.
+    [[nodiscard]] Metadata plannedMetadata(const Metadata& metadata, const ComputedOptions& computed) const;
 
+    //! Where an output goes, from its path without an extension. Segmented outputs get a folder of their own.
+    std::variant<QString, Message> PrepareOutputPath(const EncoderOptions& options, const QString& stemPath) const;
     std::variant<QString, Message> extensionForContainer(const Container& container) const;
 
-    QString output = "";
-    QString parseOutput() const;
-
-    QEventLoop eventLoop;
-    QProcess* ffmpeg = new QProcess(&eventLoop);
-
-    QMetaObject::Connection processUpdateConnection;
-    QMetaObject::Connection processFinishedConnection;
+    QString parseOutput(const QString& output) const;
+
+    // headers, tags and seek tables written once per file
+    const double containerHeaderKb = 32;
+    // long enough for rate control to settle, short enough to wait for
+    const double previewSeconds = 5;
+    // file names carry two digits of sequence numbers
+    const int maxParts = 99;
+    // short enough for playback to start soon, long enough for each segment to compress well
+    const double segmentSeconds = 4;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    RateControlRegistry& rateControl;
+    OvershootModel& overshootModel;
+    ImageConverter& imageConverter;
+    LoudnessAnalyzer& loudnessAnalyzer;
+    CropDetector& cropDetector;
+    DecimationAnalyzer& decimationAnalyzer;
+    TrimAnalyzer& trimAnalyzer;
+    DuplicateFinder& duplicateFinder;
+    KeyframeIndex& keyframeIndex;
+    SceneCutDetector& sceneCutDetector;
+    ResolutionLadder resolutionLadder;
+    BitrateLadder bitrateLadder;
+    AnimatedImagePlanner animatedImagePlanner;
+    SmartCutPlanner smartCutPlanner;
+    QTemporaryDir previewDirectory; // kept until exit, so that previews can still be played
+    int previewCount = 0;
 };
 
 #endif // MEDIAENCODER_H
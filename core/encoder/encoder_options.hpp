@@ -10,6 +10,23 @@
 
 using std::optional;
 
+enum class SpeedTier
+{
+    Fastest,
+    Fast,
+    Balanced,
+    Efficient,
+    Archival
+};
+
+//! Outputs that can be read while they are still being written.
+enum class StreamingFormat
+{
+    FragmentedMp4, // a single file, in self-contained fragments
+    Hls,           // segments listed in an m3u8 playlist
+    Dash           // segments listed in an mpd manifest
+};
+
 struct EncoderOptions
 {
     const Metadata inputMetadata;
@@ -19,6 +36,8 @@ struct EncoderOptions
     const optional<const Codec> audioCodec;
     const Container container;
     const optional<const double> sizeKbps;
+    const optional<const double> videoBitrateKbps;
+    const optional<const int> constantQualityPercent;
     const optional<const double> audioQualityPercent;
     const optional<const int> audioChannelsCount;
     const optional<const int> outputWidth;
@@ -26,6 +45,18 @@ struct EncoderOptions
     const optional<const QPoint> aspectRatio;
     const optional<const int> fps;
     const optional<const double> speed;
+    const optional<const SpeedTier> speedTier;
+    const optional<const StreamingFormat> streamingFormat;
+    const optional<const double> loudnessLufs;
+    const optional<const double> trimStartSeconds;
+    const optional<const double> trimEndSeconds;
+    const optional<const double> followIdleSeconds;
+    const bool autoResolution = false;
+    const bool autoCrop = false;
+    const bool decimate = false;
+    const bool autoTrim = false;
+    const bool splitIntoParts = false;
+    const bool snapToSceneCuts = false;
     const double minVideoBitrateKbps = 64;
     const double minAudioBitrateKbps = 16;
     const double maxAudioBitrateKbps = 256;
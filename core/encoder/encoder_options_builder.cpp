@@ -2,6 +2,43 @@
 
 #include <QFile>
 
+EncoderOptionsBuilder::EncoderOptionsBuilder(const EncoderOptions& options)
+    : inputMetadata(options.inputMetadata)
+    , inputPath(options.inputPath)
+    , outputPath(options.outputPath)
+    , videoCodec(options.videoCodec)
+    , audioCodec(options.audioCodec)
+    , container(options.container)
+    , sizeKbps(options.sizeKbps)
+    , videoBitrateKbps(options.videoBitrateKbps)
+    , constantQualityPercent(options.constantQualityPercent)
+    , audioQualityPercent(options.audioQualityPercent)
+    , audioChannelsCount(options.audioChannelsCount)
+    , outputWidth(options.outputWidth)
+    , outputHeight(options.outputHeight)
+    , aspectRatio(options.aspectRatio)
+    , fps(options.fps)
+    , speed(options.speed)
+    , speedTier(options.speedTier)
+    , streamingFormat(options.streamingFormat)
+    , loudnessLufs(options.loudnessLufs)
+    , trimStartSeconds(options.trimStartSeconds)
+    , trimEndSeconds(options.trimEndSeconds)
+    , followIdleSeconds(options.followIdleSeconds)
+    , autoResolution(options.autoResolution)
+    , autoCrop(options.autoCrop)
+    , decimate(options.decimate)
+    , autoTrim(options.autoTrim)
+    , splitIntoParts(options.splitIntoParts)
+    , snapToSceneCuts(options.snapToSceneCuts)
+    , minVideoBitrateKbps(options.minVideoBitrateKbps)
+    , minAudioBitrateKbps(options.minAudioBitrateKbps)
+    , maxAudioBitrateKbps(options.maxAudioBitrateKbps)
+    , overshootCorrectionPercent(options.overshootCorrectionPercent)
+    , customArguments(options.customArguments)
+{
+}
+
 EncoderOptionsBuilder::self& EncoderOptionsBuilder::useMetadata(const Metadata& metadata)
 {
     this->inputMetadata = metadata;
@@ -60,6 +97,7 @@ EncoderOptionsBuilder::self& EncoderOptionsBuilder::withTargetOutputSize(double
 {
     if (sizeKbps == 0)
     { // auto-mode
+        this->sizeKbps.reset();
         return *this;
     }
 
@@ -73,6 +111,42 @@ EncoderOptionsBuilder::self& EncoderOptionsBuilder::withTargetOutputSize(double
     return *this;
 }
 
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withVideoBitrate(double bitrateKbps)
+{
+    if (bitrateKbps == 0)
+    { // auto-mode
+        this->videoBitrateKbps.reset();
+        return *this;
+    }
+
+    if (bitrateKbps < 0)
+    {
+        errors.append(QObject::tr("Video bitrate must be greater than 0."));
+        return *this;
+    }
+
+    this->videoBitrateKbps = bitrateKbps;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withConstantQuality(int qualityPercent)
+{
+    if (qualityPercent == 0)
+    { // auto-mode
+        this->constantQualityPercent.reset();
+        return *this;
+    }
+
+    if (qualityPercent < 0 || qualityPercent > 100)
+    {
+        errors.append(QObject::tr("Constant quality must be between 0 and 100."));
+        return *this;
+    }
+
+    this->constantQualityPercent = qualityPercent;
+    return *this;
+}
+
 EncoderOptionsBuilder::self& EncoderOptionsBuilder::withAudioQuality(double audioQualityPercent)
 {
     if (audioQualityPercent < 0 || audioQualityPercent > 100)
@@ -180,6 +254,116 @@ EncoderOptionsBuilder::self& EncoderOptionsBuilder::atSpeed(double speed)
     return *this;
 }
 
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::atSpeedTier(SpeedTier speedTier)
+{
+    this->speedTier = speedTier;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withStreamingFormat(StreamingFormat streamingFormat)
+{
+    this->streamingFormat = streamingFormat;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withLoudnessTarget(double lufs)
+{
+    if (lufs == 0)
+    { // disabled
+        this->loudnessLufs.reset();
+        return *this;
+    }
+
+    // the range accepted by FFmpeg's loudnorm filter
+    if (lufs < -70 || lufs > -5)
+    {
+        errors.append(QObject::tr("Loudness target must be between -70 and -5 LUFS."));
+        return *this;
+    }
+
+    this->loudnessLufs = lufs;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withTrim(double startSeconds, double endSeconds)
+{
+    if (startSeconds < 0 || endSeconds < 0)
+    {
+        errors.append(QObject::tr("Trim times cannot be negative."));
+        return *this;
+    }
+
+    if (endSeconds > 0 && endSeconds <= startSeconds)
+    {
+        errors.append(QObject::tr("The trim must end after it starts."));
+        return *this;
+    }
+
+    this->trimStartSeconds.reset();
+    this->trimEndSeconds.reset();
+
+    if (startSeconds > 0)
+        this->trimStartSeconds = startSeconds;
+    if (endSeconds > 0) // otherwise up to the end
+        this->trimEndSeconds = endSeconds;
+
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::followUntilIdle(double idleSeconds)
+{
+    if (idleSeconds == 0)
+    { // reads the input as it is
+        this->followIdleSeconds.reset();
+        return *this;
+    }
+
+    if (idleSeconds < 0)
+    {
+        errors.append(QObject::tr("The time a growing input may stay idle must be greater than 0."));
+        return *this;
+    }
+
+    this->followIdleSeconds = idleSeconds;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withAutoResolution(bool enabled)
+{
+    this->autoResolution = enabled;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withAutoCrop(bool enabled)
+{
+    this->autoCrop = enabled;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withDecimation(bool enabled)
+{
+    this->decimate = enabled;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withAutoTrim(bool enabled)
+{
+    this->autoTrim = enabled;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withSplitIntoParts(bool enabled)
+{
+    this->splitIntoParts = enabled;
+    return *this;
+}
+
+EncoderOptionsBuilder::self& EncoderOptionsBuilder::withSceneCutSnapping(bool enabled)
+{
+    this->snapToSceneCuts = enabled;
+    return *this;
+}
+
 EncoderOptionsBuilder::self& EncoderOptionsBuilder::withMinVideoBitrate(double bitrateKbps)
 {
     if (bitrateKbps <= 0)
@@ -245,6 +429,37 @@ std::variant<EncoderOptions, QList<QString>> EncoderOptionsBuilder::build()
     if (!container.has_value())
         errors.append(QObject::tr("No container was specified."));
 
+    if (sizeKbps.has_value() && constantQualityPercent.has_value())
+        errors.append(QObject::tr("A desired file size and a constant quality cannot be used together."));
+
+    if (videoBitrateKbps.has_value() && (sizeKbps.has_value() || constantQualityPercent.has_value()))
+        errors.append(QObject::tr("A video bitrate cannot be combined with a desired file size or a constant quality."));
+
+    if (loudnessLufs.has_value() && (!audioCodec.has_value() || audioCodec->libraryName == "copy"))
+        errors.append(QObject::tr("Normalizing the loudness requires an audio codec other than passthrough."));
+
+    if (decimate && (!videoCodec.has_value() || videoCodec->libraryName == "copy"))
+        errors.append(QObject::tr("Dropping duplicate frames requires a video codec other than passthrough."));
+
+    if (autoTrim && (trimStartSeconds.has_value() || trimEndSeconds.has_value()))
+        errors.append(QObject::tr("Trimming dead ends cannot be combined with a manual trim."));
+
+    if (splitIntoParts && (!sizeKbps.has_value() || !videoCodec.has_value() || videoCodec->libraryName == "copy"))
+        errors.append(QObject::tr("Splitting into parts requires a desired file size and a video codec other than passthrough."));
+
+    if (splitIntoParts && streamingFormat.has_value())
+        errors.append(QObject::tr("A streaming output cannot be split into parts."));
+
+    // the duration of a growing input is only known once it stops growing
+    if (followIdleSeconds.has_value() && sizeKbps.has_value())
+        errors.append(QObject::tr("A desired file size cannot be met while following a growing input. Use a constant quality instead."));
+
+    if (followIdleSeconds.has_value() && (trimStartSeconds.has_value() || trimEndSeconds.has_value() || autoTrim || loudnessLufs.has_value()))
+        errors.append(QObject::tr("Trimming and normalizing the loudness need the whole input, so they cannot be combined with following a growing one."));
+
+    if (inputMetadata.has_value() && inputMetadata->durationSeconds > 0 && trimStartSeconds.value_or(0) >= inputMetadata->durationSeconds)
+        errors.append(QObject::tr("The trim starts after the end of the input."));
+
     if (minAudioBitrateKbps > maxAudioBitrateKbps)
         errors.append(QObject::tr("Minimum audio bitrate must be less than or equal to maximum audio bitrate."));
 
@@ -260,6 +475,8 @@ std::variant<EncoderOptions, QList<QString>> EncoderOptionsBuilder::build()
         .audioCodec = audioCodec,
         .container = *container,
         .sizeKbps = sizeKbps,
+        .videoBitrateKbps = videoBitrateKbps,
+        .constantQualityPercent = constantQualityPercent,
         .audioQualityPercent = audioQualityPercent,
         .audioChannelsCount = audioChannelsCount,
         .outputWidth = outputWidth,
@@ -267,6 +484,18 @@ std::variant<EncoderOptions, QList<QString>> EncoderOptionsBuilder::build()
         .aspectRatio = aspectRatio,
         .fps = fps,
         .speed = speed,
+        .speedTier = speedTier,
+        .streamingFormat = streamingFormat,
+        .loudnessLufs = loudnessLufs,
+        .trimStartSeconds = trimStartSeconds,
+        .trimEndSeconds = trimEndSeconds,
+        .followIdleSeconds = followIdleSeconds,
+        .autoResolution = autoResolution,
+        .autoCrop = autoCrop,
+        .decimate = decimate,
+        .autoTrim = autoTrim,
+        .splitIntoParts = splitIntoParts,
+        .snapToSceneCuts = snapToSceneCuts,
         .minVideoBitrateKbps = minVideoBitrateKbps,
         .minAudioBitrateKbps = minAudioBitrateKbps,
         .maxAudioBitrateKbps = maxAudioBitrateKbps,
@@ -13,6 +13,10 @@ class EncoderOptionsBuilder
     typedef EncoderOptionsBuilder self;
 
 public:
+    EncoderOptionsBuilder() = default;
+    //! Starts from existing options, e.g. to derive variants of them.
+    explicit EncoderOptionsBuilder(const EncoderOptions& options);
+
     self& useMetadata(const Metadata& metadata);
     self& inputFrom(const QString& inputPath);
     self& outputTo(const QString& outputPath);
@@ -20,6 +24,8 @@ public:
     self& withAudioCodec(const Codec& codec);
     self& withContainer(const Container& container);
     self& withTargetOutputSize(double sizeKbps);
+    self& withVideoBitrate(double bitrateKbps);
+    self& withConstantQuality(int qualityPercent);
     self& withAudioQuality(double audioQualityPercent);
     self& withAudioChannelsCount(int audioChannelsCount);
     self& withOutputWidth(int outputWidth);
@@ -27,6 +33,30 @@ public:
     self& withAspectRatio(const QPoint& aspectRatio);
     self& atFps(int fps);
     self& atSpeed(double speed);
+    self& atSpeedTier(SpeedTier speedTier);
+    //! Writes the output so that it can be played or uploaded while it is encoded, in place of the container.
+    self& withStreamingFormat(StreamingFormat streamingFormat);
+    //! Normalizes the integrated loudness of the audio to the given LUFS, e.g. -16 for streaming or -23 for broadcast.
+    self& withLoudnessTarget(double lufs);
+    //! Keeps only part of the input, 0 standing for its start or end. With passthrough video, the part is cut at the
+    //! exact frames anyway, see SmartCutPlanner.
+    self& withTrim(double startSeconds, double endSeconds);
+    //! Reads an input that is still being written as it grows, until it has not grown for the given time. 0 reads
+    //! it as it is.
+    self& followUntilIdle(double idleSeconds);
+    self& withAutoResolution(bool enabled);
+    //! Crops black bars found by analyzing the input, see CropDetector.
+    self& withAutoCrop(bool enabled);
+    //! Drops duplicate frames and writes a variable frame rate, which suits screen recordings.
+    self& withDecimation(bool enabled);
+    //! Skips dead air and black frames at both ends of the input, see TrimAnalyzer.
+    self& withAutoTrim(bool enabled);
+    //! Splits the output into as few parts as it takes for each of them to fit the target size at a watchable
+    //! bitrate, instead of squeezing the whole input into it.
+    self& withSplitIntoParts(bool enabled);
+    //! Moves the boundaries of parts to nearby scene changes, see SceneCutDetector. Finding them decodes the whole
+    //! input before any part is encoded.
+    self& withSceneCutSnapping(bool enabled);
     self& withMinVideoBitrate(double bitrateKbps);
     self& withMinAudioBitrate(double bitrateKbps);
     self& withMaxAudioBitrate(double bitrateKbps);
@@ -43,6 +73,8 @@ private:
     optional<Codec> audioCodec;
     optional<Container> container;
     optional<double> sizeKbps;
+    optional<double> videoBitrateKbps;
+    optional<int> constantQualityPercent;
     optional<double> audioQualityPercent;
     optional<int> audioChannelsCount;
     optional<int> outputWidth;
@@ -50,6 +82,18 @@ private:
     optional<QPoint> aspectRatio;
     optional<int> fps;
     optional<double> speed;
+    optional<SpeedTier> speedTier;
+    optional<StreamingFormat> streamingFormat;
+    optional<double> loudnessLufs;
+    optional<double> trimStartSeconds;
+    optional<double> trimEndSeconds;
+    optional<double> followIdleSeconds;
+    bool autoResolution = false;
+    bool autoCrop = false;
+    bool decimate = false;
+    bool autoTrim = false;
+    bool splitIntoParts = false;
+    bool snapToSceneCuts = false;
     double minVideoBitrateKbps = 64;
     double minAudioBitrateKbps = 16;
     double maxAudioBitrateKbps = 256;
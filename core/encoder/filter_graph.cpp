@@ -0,0 +1,215 @@
+#include "filter_graph.hpp"
+
+#include <QStringList>
+
+namespace
+{
+bool isSame(double a, double b)
+{
+    return qAbs(a - b) < 0.01;
+}
+
+// FFmpeg's -1 keeps the aspect ratio and -2 additionally rounds to an even value
+double derivedDimension(int mode, double value)
+{
+    return mode == -2 ? qRound(value / 2) * 2 : qRound(value);
+}
+}
+
+FilterGraph::FilterGraph(const StreamState& input)
+    : input(input)
+    , current(input)
+{
+}
+
+FilterGraph::self& FilterGraph::crop(int width, int height, int x, int y)
+{
+    StreamState output = current;
+    output.width = width;
+    output.height = height;
+
+    return append({
+        .name = "crop",
+        .arguments = QStringList { QString::number(width), QString::number(height), QString::number(x), QString::number(y) }.join(':'),
+        .cost = Cost::PerPixel,
+        .output = output,
+        .isNoOp = isSame(width, current.width) && isSame(height, current.height),
+    });
+}
+
+FilterGraph::self& FilterGraph::scale(int width, int height)
+{
+    StreamState output = current;
+    const bool isKnown = current.width > 0 && current.height > 0;
+
+    if (isKnown)
+    {
+        output.width = width > 0 ? width : derivedDimension(width, height * current.width / current.height);
+        output.height = height > 0 ? height : derivedDimension(height, width * current.height / current.width);
+
+        // scale keeps the display aspect ratio by adjusting the sample aspect ratio
+        output.sampleAspectRatio = current.sampleAspectRatio * (output.height * current.width) / (output.width * current.height);
+    }
+
+    return append({
+        .name = "scale",
+        .arguments = QString("%1:%2").arg(QString::number(width), QString::number(height)),
+        .cost = Cost::PerPixel,
+        .output = output,
+        .isNoOp = isKnown && isSame(output.width, current.width) && isSame(output.height, current.height),
+    });
+}
+
+FilterGraph::self& FilterGraph::setSar(int numerator, int denominator)
+{
+    StreamState output = current;
+    output.sampleAspectRatio = static_cast<double>(numerator) / denominator;
+
+    return append({
+        .name = "setsar",
+        .arguments = QString("%1/%2").arg(QString::number(numerator), QString::number(denominator)),
+        .cost = Cost::Metadata,
+        .output = output,
+        .isNoOp = current.width > 0 && isSame(output.sampleAspectRatio, current.sampleAspectRatio),
+    });
+}
+
+FilterGraph::self& FilterGraph::setPts(double factor)
+{
+    StreamState output = current;
+    output.frameRate = current.frameRate / factor;
+
+    return append({
+        .name = "setpts",
+        .arguments = QString("%1*PTS").arg(QString::number(factor)),
+        .cost = Cost::Temporal,
+        .output = output,
+        .isNoOp = isSame(factor, 1),
+    });
+}
+
+FilterGraph::self& FilterGraph::fps(double fps)
+{
+    StreamState output = current;
+    output.frameRate = fps;
+
+    const bool isKnown = current.frameRate > 0;
+
+    return append({
+        .name = "fps",
+        .arguments = QString::number(fps),
+        .cost = Cost::Temporal,
+        .output = output,
+        .isNoOp = isKnown && isSame(fps, current.frameRate),
+        .frameRatio = isKnown ? fps / current.frameRate : 1,
+    });
+}
+
+FilterGraph::self& FilterGraph::select(const QString& expression, double expectedFrameRatio)
+{
+    return add("select", QString("'%1'").arg(expression), Cost::Temporal, expectedFrameRatio);
+}
+
+FilterGraph::self& FilterGraph::decimate(int maxDroppedFrames, double expectedFrameRatio)
+{
+    StreamState output = current;
+    output.frameRate = current.frameRate * expectedFrameRatio;
+
+    return append({
+        .name = "mpdecimate",
+        .arguments = QString("max=%1").arg(maxDroppedFrames),
+        .cost = Cost::Temporal,
+        .output = output,
+        .frameRatio = expectedFrameRatio,
+    });
+}
+
+FilterGraph::self& FilterGraph::add(const QString& name, const QString& arguments, Cost cost, double frameRatio)
+{
+    return append({
+        .name = name,
+        .arguments = arguments,
+        .cost = cost,
+        .output = current,
+        .frameRatio = frameRatio,
+    });
+}
+
+QList<FilterGraph::Node> FilterGraph::optimized() const
+{
+    QList<Node> temporal;
+    QList<Node> others;
+    QList<Node> original;
+    double frameRatio = 1;
+
+    for (const Node& node : nodes)
+    {
+        if (node.isNoOp)
+            continue;
+
+        original.append(node);
+
+        if (node.cost == Cost::Temporal)
+        {
+            temporal.append(node);
+            frameRatio *= node.frameRatio;
+        }
+        else
+        {
+            others.append(node);
+        }
+    }
+
+    // per-pixel work is cheapest on whichever side of the temporal filters has the fewest frames
+    QList<Node> ordered = original;
+    if (frameRatio < 1 && !isSame(frameRatio, 1))
+        ordered = temporal + others;
+    else if (frameRatio > 1 && !isSame(frameRatio, 1))
+        ordered = others + temporal;
+
+    QList<Node> merged;
+
+    for (const Node& node : ordered)
+    {
+        const bool isKnown = node.output.width > 0 && node.output.height > 0;
+
+        if (node.name != "scale" || !isKnown || merged.isEmpty() || merged.last().name != "scale")
+        {
+            merged.append(node);
+            continue;
+        }
+
+        // the last scale decides the output size, so resolve it and apply it to the first one's input
+        Node scale = node;
+        scale.input = merged.takeLast().input;
+        scale.arguments = QString("%1:%2").arg(QString::number(node.output.width), QString::number(node.output.height));
+
+        if (!isSame(scale.output.width, scale.input.width) || !isSame(scale.output.height, scale.input.height))
+            merged.append(scale);
+    }
+
+    return merged;
+}
+
+QString FilterGraph::toString() const
+{
+    QStringList filters;
+
+    for (const Node& node : optimized())
+        filters.append(render(node));
+
+    return filters.join(',');
+}
+
+FilterGraph::self& FilterGraph::append(Node node)
+{
+    node.input = current;
+    current = node.output;
+    nodes.append(node);
+    return *this;
+}
+
+QString FilterGraph::render(const Node& node)
+{
+    return node.arguments.isEmpty() ? node.name : node.name + "=" + node.arguments;
+}
@@ -0,0 +1,71 @@
+#ifndef FILTER_GRAPH_H
+#define FILTER_GRAPH_H
+
+#include <QList>
+#include <QString>
+
+//!
+//! \brief Builds a linear FFmpeg filter chain from typed nodes.
+//! \details Nodes are added in their logical order. When rendered, nodes that would not change the stream are
+//! dropped, filters that reduce the frame count are moved ahead of per-pixel filters so fewer frames get processed, and
+//! adjacent scales are merged into one.
+//!
+class FilterGraph
+{
+    typedef FilterGraph self;
+
+public:
+    struct StreamState
+    {
+        double width = 0;
+        double height = 0;
+        double frameRate = 0;
+        double sampleAspectRatio = 1;
+    };
+
+    enum class Cost
+    {
+        Temporal, // retimes, drops or duplicates frames without looking at them
+        PerPixel, // processes every pixel of every frame
+        Metadata  // only changes stream properties
+    };
+
+    struct Node
+    {
+        QString name;
+        QString arguments;
+        Cost cost;
+        StreamState output;
+        StreamState input;
+        bool isNoOp = false;
+        double frameRatio = 1; // output frames per input frame
+    };
+
+    explicit FilterGraph(const StreamState& input);
+
+    //! Non-positive dimensions are derived from the other one, as with FFmpeg's -1 and -2.
+    self& crop(int width, int height, int x, int y);
+    self& scale(int width, int height);
+    self& setSar(int numerator, int denominator);
+    self& setPts(double factor);
+    self& fps(double fps);
+    self& select(const QString& expression, double expectedFrameRatio);
+    //! Drops frames that barely differ from the previous one; the frame rate becomes the expected average.
+    self& decimate(int maxDroppedFrames, double expectedFrameRatio);
+    self& add(const QString& name, const QString& arguments, Cost cost, double frameRatio = 1);
+
+    [[nodiscard]] QList<Node> optimized() const;
+    [[nodiscard]] QString toString() const;
+    [[nodiscard]] bool isEmpty() const { return toString().isEmpty(); }
+    [[nodiscard]] const StreamState& output() const { return current; }
+
+private:
+    self& append(Node node);
+    [[nodiscard]] static QString render(const Node& node);
+
+    const StreamState input;
+    StreamState current;
+    QList<Node> nodes;
+};
+
+#endif
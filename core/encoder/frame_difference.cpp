@@ -0,0 +1,136 @@
+#include "frame_difference.hpp"
+
+#include <cstdlib>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FRAME_DIFFERENCE_X86
+#include <immintrin.h>
+#endif
+
+std::vector<FrameDifference::Kernel> FrameDifference::kernels()
+{
+    std::vector<Kernel> kernels { { "scalar", &FrameDifference::sadScalar } };
+
+#ifdef FRAME_DIFFERENCE_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2"))
+        kernels.push_back({ "sse2", &FrameDifference::sadSse2 });
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back({ "avx2", &FrameDifference::sadAvx2 });
+#endif
+
+    return kernels;
+}
+
+FrameDifference::SadKernel FrameDifference::fastestSad()
+{
+    static const SadKernel fastest = kernels().back().sad;
+    return fastest;
+}
+
+std::uint64_t FrameDifference::sadScalar(const std::uint8_t* a, const std::uint8_t* b, std::size_t size)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < size; i++)
+        sum += static_cast<std::uint64_t>(std::abs(a[i] - b[i]));
+
+    return sum;
+}
+
+#ifdef FRAME_DIFFERENCE_X86
+
+__attribute__((target("sse2"))) std::uint64_t FrameDifference::sadSse2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size)
+{
+    // psadbw sums 8 byte differences into each 64-bit half, so the accumulator cannot overflow
+    __m128i sums = _mm_setzero_si128();
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(x, y));
+    }
+
+    std::uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+
+    return lanes[0] + lanes[1] + sadScalar(a + i, b + i, size - i);
+}
+
+__attribute__((target("avx2"))) std::uint64_t FrameDifference::sadAvx2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size)
+{
+    // two accumulators keep consecutive iterations independent of each other
+    __m256i first = _mm256_setzero_si256();
+    __m256i second = _mm256_setzero_si256();
+    std::size_t i = 0;
+
+    for (; i + 64 <= size; i += 64)
+    {
+        const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32));
+        const __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32));
+
+        first = _mm256_add_epi64(first, _mm256_sad_epu8(x0, y0));
+        second = _mm256_add_epi64(second, _mm256_sad_epu8(x1, y1));
+    }
+
+    const __m256i sums = _mm256_add_epi64(first, second);
+    const __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    std::uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), halves);
+
+    return lanes[0] + lanes[1] + sadSse2(a + i, b + i, size - i);
+}
+
+#else
+
+std::uint64_t FrameDifference::sadSse2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size)
+{
+    return sadScalar(a, b, size);
+}
+
+std::uint64_t FrameDifference::sadAvx2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size)
+{
+    return sadScalar(a, b, size);
+}
+
+#endif
+
+FrameDifference::Histogram FrameDifference::histogram(const std::uint8_t* plane, std::size_t size)
+{
+    // separate partial counts let consecutive pixels of the same value increment different counters
+    std::array<Histogram, 4> partial {};
+    std::size_t i = 0;
+
+    for (; i + 4 <= size; i += 4)
+    {
+        partial[0][plane[i] >> 2]++;
+        partial[1][plane[i + 1] >> 2]++;
+        partial[2][plane[i + 2] >> 2]++;
+        partial[3][plane[i + 3] >> 2]++;
+    }
+
+    for (; i < size; i++)
+        partial[0][plane[i] >> 2]++;
+
+    Histogram bins {};
+    for (std::size_t bin = 0; bin < bins.size(); bin++)
+        bins[bin] = partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+
+    return bins;
+}
+
+double FrameDifference::histogramDistance(const Histogram& a, const Histogram& b, std::size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    std::uint64_t moved = 0;
+    for (std::size_t bin = 0; bin < a.size(); bin++)
+        moved += a[bin] > b[bin] ? a[bin] - b[bin] : b[bin] - a[bin];
+
+    return static_cast<double>(moved) / (2.0 * static_cast<double>(size));
+}
@@ -0,0 +1,40 @@
+#ifndef FRAME_DIFFERENCE_H
+#define FRAME_DIFFERENCE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//!
+//! \brief Kernels comparing consecutive 8-bit luma planes, for scene-cut detection.
+//! \details The sum of absolute differences is computed with SSE2 or AVX2 when the CPU has them, picked once at
+//! runtime, and with plain C++ otherwise. Histograms are cheap next to it and stay scalar, since byte scatters do not
+//! vectorize. Nothing here depends on Qt, so the kernels can be benchmarked on their own.
+//!
+class FrameDifference
+{
+public:
+    using SadKernel = std::uint64_t (*)(const std::uint8_t* a, const std::uint8_t* b, std::size_t size);
+    using Histogram = std::array<std::uint32_t, 64>;
+
+    struct Kernel
+    {
+        const char* name;
+        SadKernel sad;
+    };
+
+    //! Every kernel this CPU can run, from the slowest to the fastest.
+    [[nodiscard]] static std::vector<Kernel> kernels();
+    [[nodiscard]] static SadKernel fastestSad();
+
+    [[nodiscard]] static std::uint64_t sadScalar(const std::uint8_t* a, const std::uint8_t* b, std::size_t size);
+    [[nodiscard]] static std::uint64_t sadSse2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size);
+    [[nodiscard]] static std::uint64_t sadAvx2(const std::uint8_t* a, const std::uint8_t* b, std::size_t size);
+
+    [[nodiscard]] static Histogram histogram(const std::uint8_t* plane, std::size_t size);
+    //! Fraction of the pixels that changed bins, from 0 for the same distribution to 1 for disjoint ones.
+    [[nodiscard]] static double histogramDistance(const Histogram& a, const Histogram& b, std::size_t size);
+};
+
+#endif
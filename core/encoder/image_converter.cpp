@@ -0,0 +1,123 @@
+#include "image_converter.hpp"
+
+#include <QBuffer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QtConcurrent/QtConcurrentMap>
+
+QByteArray ImageConverter::formatFor(const Codec& codec)
+{
+    static const QHash<QString, QByteArray> formats {
+        { "mjpeg", "jpg" },
+        { "png", "png" },
+        { "libwebp", "webp" },
+        { "bmp", "bmp" },
+        { "tiff", "tiff" },
+    };
+
+    const QByteArray format = formats.value(codec.libraryName);
+    return QImageWriter::supportedImageFormats().contains(format) ? format : QByteArray();
+}
+
+bool ImageConverter::isStillImage(const QString& path)
+{
+    const QImageReader reader(path);
+    return reader.canRead() && (!reader.supportsAnimation() || reader.imageCount() <= 1);
+}
+
+QFuture<ImageConverter::Result> ImageConverter::Convert(const QList<Job>& jobs) const
+{
+    return QtConcurrent::mapped(jobs, &ImageConverter::convert);
+}
+
+ImageConverter::Result ImageConverter::convert(const Job& job)
+{
+    Result result { .outputPath = job.outputPath + "." + job.format };
+
+    QImageReader reader(job.inputPath);
+    reader.setAutoTransform(true);
+
+    // decoders such as JPEG's can scale while decoding, which is much cheaper than scaling afterwards
+    if (job.size.width() > 0 || job.size.height() > 0)
+    {
+        const QSize source = reader.size();
+        QSize scaled = job.size;
+
+        if (scaled.width() <= 0 && source.height() > 0)
+            scaled.setWidth(qRound(static_cast<double>(source.width()) * scaled.height() / source.height()));
+        if (scaled.height() <= 0 && source.width() > 0)
+            scaled.setHeight(qRound(static_cast<double>(source.height()) * scaled.width() / source.width()));
+
+        reader.setScaledSize(scaled);
+    }
+
+    const QImage image = reader.read();
+    if (image.isNull())
+    {
+        result.error = reader.errorString();
+        return result;
+    }
+
+    QBuffer probe;
+    const bool hasQuality = QImageWriter(&probe, job.format).supportsOption(QImageIOHandler::Quality);
+    const bool hasSizeTarget = job.sizeKbps.has_value() && hasQuality;
+
+    int quality = hasQuality ? job.qualityPercent.value_or(-1) : -1;
+    QByteArray data = encode(image, job.format, hasSizeTarget ? 1 : quality);
+
+    if (hasSizeTarget)
+    {
+        // the lowest quality is kept when even it does not fit, since nothing gets closer
+        quality = 1;
+        int low = 2;
+        int high = 100;
+
+        while (low <= high)
+        {
+            const int middle = (low + high) / 2;
+            const QByteArray candidate = encode(image, job.format, middle);
+
+            if (candidate.size() / 125.0 <= *job.sizeKbps)
+            {
+                data = candidate;
+                quality = middle;
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle - 1;
+            }
+        }
+    }
+
+    if (data.isEmpty())
+    {
+        result.error = QObject::tr("Could not encode the image as %1.").arg(job.format);
+        return result;
+    }
+
+    QFile output(result.outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate) || output.write(data) != data.size())
+    {
+        result.error = output.errorString();
+        return result;
+    }
+
+    result.sizeKbps = data.size() / 125.0;
+    result.quality = quality;
+    return result;
+}
+
+QByteArray ImageConverter::encode(const QImage& image, const QByteArray& format, int quality)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+
+    QImageWriter writer(&buffer, format);
+    writer.setQuality(quality);
+
+    return writer.write(image) ? data : QByteArray();
+}
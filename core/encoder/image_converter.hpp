@@ -0,0 +1,54 @@
+#ifndef IMAGE_CONVERTER_H
+#define IMAGE_CONVERTER_H
+
+#include "core/formats/codec.hpp"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Converts still images in-process with Qt's image plugins, on the global thread pool.
+//! \details Launching FFmpeg costs more than decoding and encoding a typical screenshot, so batches of stills are
+//! bounded by disk and cores this way instead of by process creation. With a desired size, the quality setting is
+//! binary-searched against the encoded size in memory, and only the final image is written.
+//!
+class ImageConverter
+{
+public:
+    struct Job
+    {
+        QString inputPath;
+        QString outputPath; // without extension
+        QByteArray format;
+        optional<int> qualityPercent;
+        optional<double> sizeKbps;
+        QSize size; // a dimension of 0 keeps the aspect ratio
+    };
+
+    struct Result
+    {
+        QString outputPath;
+        double sizeKbps = 0;
+        int quality = -1;
+        QString error;
+        QString duplicateOf; // input converted in place of this one, which was skipped
+    };
+
+    //! Qt image format written for a video codec, or an empty one when FFmpeg has to handle it.
+    [[nodiscard]] static QByteArray formatFor(const Codec& codec);
+    [[nodiscard]] static bool isStillImage(const QString& path);
+
+    [[nodiscard]] QFuture<Result> Convert(const QList<Job>& jobs) const;
+    [[nodiscard]] static Result convert(const Job& job);
+
+private:
+    [[nodiscard]] static QByteArray encode(const QImage& image, const QByteArray& format, int quality);
+};
+
+#endif
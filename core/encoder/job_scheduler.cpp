@@ -0,0 +1,152 @@
+#include "job_scheduler.hpp"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+
+JobScheduler::JobScheduler(MemoryModel& memoryModel)
+    : memoryModel(memoryModel)
+    , maxConcurrentJobs(QThread::idealThreadCount())
+{
+    sampler.setInterval(500);
+    connect(&sampler, &QTimer::timeout, this, &JobScheduler::SampleMemory);
+}
+
+QProcess* JobScheduler::Submit(const Job& job)
+{
+    auto* process = new QProcess(this);
+
+    connect(process, &QProcess::finished, this, [this, process]
+    {
+        Release(process);
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            Release(process);
+    });
+
+    Enqueue({ .process = process, .job = job });
+    QMetaObject::invokeMethod(this, &JobScheduler::AdmitPending, Qt::QueuedConnection);
+
+    return process;
+}
+
+void JobScheduler::Prioritize(QProcess* process)
+{
+    for (qsizetype i = 0; i < pending.size(); i++)
+    {
+        if (pending[i].process != process || pending[i].job.isInteractive)
+            continue;
+
+        Entry entry = pending.takeAt(i);
+        entry.job.isInteractive = true;
+        Enqueue(entry);
+        AdmitPending();
+        return;
+    }
+}
+
+void JobScheduler::SetMemoryBudgetMb(double budgetMb)
+{
+    this->budgetMb = budgetMb;
+    AdmitPending();
+}
+
+void JobScheduler::SetMaxConcurrentJobs(int count)
+{
+    maxConcurrentJobs = count > 0 ? count : QThread::idealThreadCount();
+    AdmitPending();
+}
+
+void JobScheduler::SetLimitEncoderMemory(bool enabled)
+{
+    limitEncoderMemory = enabled;
+}
+
+bool JobScheduler::fitsBudgetAlone(const MemoryModel::Estimate& estimate) const
+{
+    return budgetMb <= 0 || estimate.peakMb <= budgetMb;
+}
+
+void JobScheduler::Enqueue(const Entry& entry)
+{
+    // interactive jobs keep their own order, ahead of the background ones
+    qsizetype position = entry.job.isInteractive ? 0 : pending.size();
+    while (entry.job.isInteractive && position < pending.size() && pending[position].job.isInteractive)
+        position++;
+
+    pending.insert(position, entry);
+}
+
+void JobScheduler::AdmitPending()
+{
+    while (!pending.isEmpty())
+    {
+        const Entry& next = pending.first();
+        const bool fitsBudget = budgetMb <= 0 || usedMemoryMb() + next.job.memory.peakMb <= budgetMb;
+
+        // a job too large for the budget still runs once it has the machine to itself
+        if (!running.isEmpty() && ((running.size() >= maxConcurrentJobs && !next.job.isInteractive) || !fitsBudget))
+            break;
+
+        const Entry entry = pending.takeFirst();
+        running.append(entry);
+        entry.process->startCommand(entry.job.command);
+    }
+
+    if (running.isEmpty())
+        sampler.stop();
+    else if (!sampler.isActive())
+        sampler.start();
+}
+
+void JobScheduler::SampleMemory()
+{
+    for (Entry& entry : running)
+    {
+        if (entry.process->state() != QProcess::Running)
+            continue;
+
+        entry.measuredPeakMb = qMax(entry.measuredPeakMb, readPeakMemoryMb(entry.process->processId()));
+    }
+}
+
+void JobScheduler::Release(QProcess* process)
+{
+    for (qsizetype i = 0; i < running.size(); i++)
+    {
+        if (running[i].process != process)
+            continue;
+
+        const Entry entry = running.takeAt(i);
+        memoryModel.Record(entry.job.memory, entry.measuredPeakMb);
+        break;
+    }
+
+    process->deleteLater();
+    AdmitPending();
+}
+
+double JobScheduler::usedMemoryMb() const
+{
+    double usedMb = 0;
+
+    for (const Entry& entry : running)
+        usedMb += qMax(entry.job.memory.peakMb, entry.measuredPeakMb);
+
+    return usedMb;
+}
+
+double JobScheduler::readPeakMemoryMb(qint64 pid)
+{
+    // only Linux exposes the peak resident set of another process without extra privileges or libraries
+    QFile status(QString("/proc/%1/status").arg(pid));
+    if (pid <= 0 || !status.open(QIODevice::ReadOnly))
+        return 0;
+
+    static const QRegularExpression regex(R"(VmHWM:\s+(\d+) kB)");
+    const QRegularExpressionMatch match = regex.match(status.readAll());
+
+    return match.hasMatch() ? match.captured(1).toDouble() / 1024 : 0;
+}
@@ -0,0 +1,73 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include "memory_model.hpp"
+
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+
+//!
+//! \brief Runs FFmpeg processes concurrently while keeping their combined memory usage under a budget.
+//! \details Submitted jobs are queued and only started once their estimated peak memory fits alongside the jobs that
+//! are already running. A job that does not fit the budget on its own is still started once nothing else runs. The
+//! peak memory of each process is sampled while it runs and fed back into the MemoryModel. Interactive jobs, such as
+//! previews, are started ahead of everything queued.
+//!
+class JobScheduler final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobScheduler(MemoryModel& memoryModel);
+
+    struct Job
+    {
+        QString command;
+        MemoryModel::Estimate memory;
+        // someone is waiting on the result: it skips the queue and does not count against the concurrency limit
+        bool isInteractive = false;
+    };
+
+    //! Returns the process of the job, which starts on the next event loop iteration at the earliest.
+    //! The scheduler owns the process and deletes it once it has finished.
+    QProcess* Submit(const Job& job);
+    //! Makes a job that has not started yet interactive, for when someone starts waiting on it. Does nothing otherwise.
+    void Prioritize(QProcess* process);
+
+    void SetMemoryBudgetMb(double budgetMb);
+    void SetMaxConcurrentJobs(int count);
+    void SetLimitEncoderMemory(bool enabled);
+
+    [[nodiscard]] double memoryBudgetMb() const { return budgetMb; }
+    [[nodiscard]] bool limitsEncoderMemory() const { return limitEncoderMemory; }
+    [[nodiscard]] bool fitsBudgetAlone(const MemoryModel::Estimate& estimate) const;
+
+private:
+    struct Entry
+    {
+        QProcess* process;
+        Job job;
+        double measuredPeakMb = 0;
+    };
+
+    void Enqueue(const Entry& entry);
+    void AdmitPending();
+    void SampleMemory();
+    void Release(QProcess* process);
+
+    [[nodiscard]] double usedMemoryMb() const;
+    [[nodiscard]] static double readPeakMemoryMb(qint64 pid);
+
+    MemoryModel& memoryModel;
+    QList<Entry> pending;
+    QList<Entry> running;
+    QTimer sampler;
+
+    double budgetMb = 0; // unlimited
+    int maxConcurrentJobs;
+    bool limitEncoderMemory = true;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "keyframe_index.hpp"
+
+#include <QFile>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+// the index is written and mapped as is, so its layout must not depend on padding
+static_assert(std::is_trivially_copyable_v<KeyframeIndex::Keyframe> && sizeof(KeyframeIndex::Keyframe) == 16);
+
+optional<KeyframeIndex::Keyframe> KeyframeIndex::Map::atOrBefore(double seconds) const
+{
+    const Keyframe* after = std::upper_bound(begin(), end(), seconds, [](double value, const Keyframe& keyframe) { return value < keyframe.seconds; });
+    if (after == begin())
+        return {};
+
+    return *(after - 1);
+}
+
+optional<KeyframeIndex::Keyframe> KeyframeIndex::Map::atOrAfter(double seconds) const
+{
+    const Keyframe* after = std::lower_bound(begin(), end(), seconds, [](const Keyframe& keyframe, double value) { return keyframe.seconds < value; });
+    if (after == end())
+        return {};
+
+    return *after;
+}
+
+optional<KeyframeIndex::Keyframe> KeyframeIndex::Map::nearest(double seconds) const
+{
+    const optional<Keyframe> before = atOrBefore(seconds);
+    const optional<Keyframe> after = atOrAfter(seconds);
+
+    if (!before.has_value() || !after.has_value())
+        return before.has_value() ? before : after;
+
+    return seconds - before->seconds <= after->seconds - seconds ? before : after;
+}
+
+KeyframeIndex::KeyframeIndex(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<KeyframeIndex::Map> KeyframeIndex::Load(const QString& inputPath)
+{
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (loaded.contains(identity))
+        return QtFuture::makeReadyValueFuture(loaded[identity]);
+
+    if (const optional<Map> map = mapped(cache.filePathFor(analysis, inputPath)); map.has_value())
+    {
+        loaded.insert(identity, *map);
+        return QtFuture::makeReadyValueFuture(*map);
+    }
+
+    if (pending.contains(identity))
+        return pending[identity]->promise.future();
+
+    const auto build = QSharedPointer<Build>::create();
+    build->identity = identity;
+    build->inputPath = inputPath;
+    build->promise.start();
+    pending.insert(identity, build);
+
+    StartBuild(build);
+    return build->promise.future();
+}
+
+void KeyframeIndex::StartBuild(const QSharedPointer<Build>& build)
+{
+    // packet flags come from the container, so nothing has to be decoded. The start time of the input comes last
+    const QString command = QString(R"(ffprobe -v error -select_streams v:0 -show_entries packet=pts_time,pos,flags:format=start_time -of csv=p=0 "%1")")
+                                .arg(build->inputPath);
+
+    QProcess* ffprobe = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak({}, {}) });
+
+    connect(ffprobe, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndBuild(build, {});
+    });
+
+    connect(ffprobe, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0)
+        {
+            EndBuild(build, {});
+            return;
+        }
+
+        QList<Keyframe> keyframes;
+        double startSeconds = 0;
+        for (const QString& line : QString(ffprobe->readAllStandardOutput()).split('\n', Qt::SkipEmptyParts))
+        {
+            const QStringList fields = line.trimmed().split(',');
+            if (fields.size() == 1)
+            {
+                startSeconds = fields.first().toDouble();
+                continue;
+            }
+
+            bool isNumber = false;
+            const double seconds = fields.value(0).toDouble(&isNumber);
+
+            if (!isNumber || !fields.value(2).startsWith('K'))
+                continue;
+
+            bool hasOffset = false;
+            const qint64 byteOffset = fields.value(1).toLongLong(&hasOffset);
+            keyframes.append({ .seconds = seconds, .byteOffset = hasOffset ? byteOffset : -1 });
+        }
+
+        // FFmpeg seeks from the start time of the input, which MPEG-TS and edit lists move away from 0
+        for (Keyframe& keyframe : keyframes)
+            keyframe.seconds -= startSeconds;
+
+        // packets are listed in decoding order
+        std::sort(keyframes.begin(), keyframes.end(), [](const Keyframe& a, const Keyframe& b) { return a.seconds < b.seconds; });
+        EndBuild(build, keyframes);
+    });
+}
+
+void KeyframeIndex::EndBuild(const QSharedPointer<Build>& build, const optional<QList<Keyframe>>& keyframes)
+{
+    pending.remove(build->identity);
+
+    Map map;
+    if (const QString filePath = cache.filePathFor(analysis, build->inputPath); keyframes.has_value() && write(filePath, *keyframes))
+    {
+        if (const optional<Map> written = mapped(filePath); written.has_value())
+        {
+            map = *written;
+            loaded.insert(build->identity, map);
+        }
+    }
+
+    build->promise.addResult(map);
+    build->promise.finish();
+}
+
+bool KeyframeIndex::write(const QString& filePath, const QList<Keyframe>& keyframes) const
+{
+    Header header {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.count = keyframes.size();
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const qint64 keyframesSize = keyframes.size() * static_cast<qint64>(sizeof(Keyframe));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(keyframes.constData()), keyframesSize);
+
+    return file.commit();
+}
+
+optional<KeyframeIndex::Map> KeyframeIndex::mapped(const QString& filePath) const
+{
+    const auto file = QSharedPointer<QFile>::create(filePath);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(Header)))
+        return {};
+
+    const uchar* data = file->map(0, file->size());
+    if (data == nullptr)
+        return {};
+
+    Header header {};
+    std::memcpy(&header, data, sizeof(header));
+
+    // a file left by another version, or cut short, is built again
+    const qint64 expectedSize = static_cast<qint64>(sizeof(Header) + header.count * sizeof(Keyframe));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || file->size() != expectedSize)
+        return {};
+
+    Map map;
+    map.file = file;
+    map.keyframes = reinterpret_cast<const Keyframe*>(data + sizeof(Header));
+    map.count = static_cast<qsizetype>(header.count);
+    return map;
+}
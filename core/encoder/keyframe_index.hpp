@@ -0,0 +1,98 @@
+#ifndef KEYFRAME_INDEX_H
+#define KEYFRAME_INDEX_H
+
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <optional>
+
+class QFile;
+
+using std::optional;
+
+//!
+//! \brief Lists where the keyframes of an input are, once per file.
+//! \details Cutting, splitting and previewing all seek to keyframes, and finding them takes a pass over every packet
+//! of the input. The first lookup of a file lists them with FFprobe in the background and writes a compact binary
+//! index next to the analysis cache; every later lookup memory-maps that file instead, so that nothing is read until
+//! it is searched. The index is in the host's byte order, as it never leaves the machine.
+//!
+//! Times are relative to the start time of the input, as FFmpeg's seeks are, rather than the raw timestamps of the
+//! container.
+//!
+class KeyframeIndex final : public QObject
+{
+public:
+    struct Keyframe
+    {
+        double seconds = 0;
+        qint64 byteOffset = -1; // -1 when the container does not tell
+    };
+
+    //! Keyframes of the first video stream in presentation order, read straight from the mapped file.
+    class Map
+    {
+    public:
+        [[nodiscard]] const Keyframe* begin() const { return keyframes; }
+        [[nodiscard]] const Keyframe* end() const { return keyframes + count; }
+        [[nodiscard]] qsizetype size() const { return count; }
+        [[nodiscard]] bool isEmpty() const { return count == 0; }
+
+        //! Last keyframe at or before a time, so that decoding from it reaches that time.
+        [[nodiscard]] optional<Keyframe> atOrBefore(double seconds) const;
+        [[nodiscard]] optional<Keyframe> atOrAfter(double seconds) const;
+        [[nodiscard]] optional<Keyframe> nearest(double seconds) const;
+
+    private:
+        friend class KeyframeIndex;
+
+        QSharedPointer<QFile> file; // keeps the mapping alive for as long as a copy is around
+        const Keyframe* keyframes = nullptr;
+        qsizetype count = 0;
+    };
+
+    explicit KeyframeIndex(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves to an empty map when the input has no video, or could not be indexed.
+    QFuture<Map> Load(const QString& inputPath);
+
+private:
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        quint64 count;
+    };
+
+    struct Build
+    {
+        QString identity;
+        QString inputPath;
+        QPromise<Map> promise;
+    };
+
+    void StartBuild(const QSharedPointer<Build>& build);
+    void EndBuild(const QSharedPointer<Build>& build, const optional<QList<Keyframe>>& keyframes);
+
+    [[nodiscard]] bool write(const QString& filePath, const QList<Keyframe>& keyframes) const;
+    [[nodiscard]] optional<Map> mapped(const QString& filePath) const;
+
+    const QString analysis = "Keyframes";
+    const char magic[4] = { 'S', 'M', 'K', 'I' };
+    const quint32 version = 2;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, Map> loaded;
+    QHash<QString, QSharedPointer<Build>> pending;
+};
+
+#endif
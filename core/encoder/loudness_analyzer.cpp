@@ -0,0 +1,128 @@
+#include "loudness_analyzer.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStringList>
+#include <cmath>
+
+LoudnessAnalyzer::LoudnessAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<optional<LoudnessAnalyzer::Measurement>> LoudnessAnalyzer::Measure(const QString& inputPath, bool isInteractive)
+{
+    if (const optional<Measurement> measurement = cached(inputPath); measurement.has_value())
+        return QtFuture::makeReadyValueFuture(measurement);
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (pending.contains(identity))
+    {
+        if (isInteractive)
+            scheduler.Prioritize(processes.value(identity));
+
+        return pending[identity]->future();
+    }
+
+    const auto promise = QSharedPointer<QPromise<optional<Measurement>>>::create();
+    promise->start();
+    pending.insert(identity, promise);
+
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -i "%1" -map 0:a:0 -af loudnorm=print_format=json -f null -)").arg(inputPath);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak({}, {}), .isInteractive = isInteractive });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+    processes.insert(identity, ffmpeg);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            Finish(identity, inputPath, {});
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        Finish(identity, inputPath, exitCode == 0 ? parse(ffmpeg->readAll()) : optional<Measurement>());
+    });
+
+    return promise->future();
+}
+
+optional<LoudnessAnalyzer::Measurement> LoudnessAnalyzer::cached(const QString& inputPath) const
+{
+    const QStringList values = cache.get(analysis, inputPath).toStringList();
+    if (values.size() != 4)
+        return {};
+
+    return Measurement {
+        .integratedLufs = values[0].toDouble(),
+        .truePeakDb = values[1].toDouble(),
+        .rangeLu = values[2].toDouble(),
+        .thresholdLufs = values[3].toDouble(),
+    };
+}
+
+QString LoudnessAnalyzer::normalizationFilter(const Measurement& measurement, double targetLufs) const
+{
+    // with the whole file measured, loudnorm applies a single gain unless that would clip the true peak
+    return QString("loudnorm=I=%1:TP=%2:LRA=%3:measured_I=%4:measured_TP=%5:measured_LRA=%6:measured_thresh=%7:linear=true,aresample=%8")
+        .arg(QString::number(targetLufs), QString::number(truePeakDb), QString::number(rangeLu),
+             QString::number(measurement.integratedLufs), QString::number(measurement.truePeakDb),
+             QString::number(measurement.rangeLu), QString::number(measurement.thresholdLufs))
+        .arg(outputSampleRate);
+}
+
+void LoudnessAnalyzer::Finish(const QString& identity, const QString& inputPath, const optional<Measurement>& measurement)
+{
+    const auto promise = pending.take(identity);
+    processes.remove(identity);
+    if (promise.isNull())
+        return;
+
+    if (measurement.has_value())
+    {
+        cache.Set(analysis, inputPath, QStringList {
+            QString::number(measurement->integratedLufs),
+            QString::number(measurement->truePeakDb),
+            QString::number(measurement->rangeLu),
+            QString::number(measurement->thresholdLufs),
+        });
+    }
+
+    promise->addResult(measurement);
+    promise->finish();
+}
+
+optional<LoudnessAnalyzer::Measurement> LoudnessAnalyzer::parse(const QString& output)
+{
+    // loudnorm prints its measurements as the last JSON object of the log
+    const qsizetype start = output.lastIndexOf('{');
+    const qsizetype end = output.lastIndexOf('}');
+    if (start < 0 || end < start)
+        return {};
+
+    const QJsonObject values = QJsonDocument::fromJson(output.mid(start, end - start + 1).toUtf8()).object();
+
+    bool isValid = true;
+    const auto number = [&values, &isValid](const QString& key)
+    {
+        bool isNumber = false;
+        const double value = values.value(key).toString().toDouble(&isNumber);
+
+        // silence measures as -inf, which no gain can bring to the target
+        isValid = isValid && isNumber && std::isfinite(value);
+        return value;
+    };
+
+    const Measurement measurement {
+        .integratedLufs = number("input_i"),
+        .truePeakDb = number("input_tp"),
+        .rangeLu = number("input_lra"),
+        .thresholdLufs = number("input_thresh"),
+    };
+
+    return isValid ? optional(measurement) : optional<Measurement>();
+}
@@ -0,0 +1,64 @@
+#ifndef LOUDNESS_ANALYZER_H
+#define LOUDNESS_ANALYZER_H
+
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Measures the loudness of inputs for two-pass normalization with FFmpeg's loudnorm filter.
+//! \details A single pass of loudnorm can only guess the loudness of what it has not heard yet, so it compresses the
+//! dynamics of the whole file. Measuring first lets the encode apply a plain gain instead. Measurements are cached
+//! per file, and a file that is already being measured is not measured a second time.
+//!
+class LoudnessAnalyzer final : public QObject
+{
+public:
+    struct Measurement
+    {
+        double integratedLufs = 0;
+        double truePeakDb = 0;
+        double rangeLu = 0;
+        double thresholdLufs = 0;
+    };
+
+    explicit LoudnessAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves right away when the file was measured before, and to nothing when it has no measurable audio.
+    //! The result can be ignored to measure ahead of time. An interactive measurement runs ahead of anything queued,
+    //! along with one of the same file that is already pending.
+    QFuture<optional<Measurement>> Measure(const QString& inputPath, bool isInteractive = false);
+    [[nodiscard]] optional<Measurement> cached(const QString& inputPath) const;
+
+    //! Filter bringing the measured audio to the target loudness, resampled back from loudnorm's 192 kHz.
+    [[nodiscard]] QString normalizationFilter(const Measurement& measurement, double targetLufs) const;
+
+private:
+    void Finish(const QString& identity, const QString& inputPath, const optional<Measurement>& measurement);
+    [[nodiscard]] static optional<Measurement> parse(const QString& output);
+
+    const QString analysis = "Loudness";
+    const double truePeakDb = -1.5;
+    const double rangeLu = 11;
+    const int outputSampleRate = 48000;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, QSharedPointer<QPromise<optional<Measurement>>>> pending;
+    QHash<QString, QPointer<QProcess>> processes;
+};
+
+#endif
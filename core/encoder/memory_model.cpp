@@ -0,0 +1,91 @@
+#include "memory_model.hpp"
+
+#include <QStringList>
+
+MemoryModel::Estimate MemoryModel::EstimatePeak(const Metadata& metadata, const optional<const Codec>& videoCodec, bool limited) const
+{
+    const QString libraryName = videoCodec.has_value() ? videoCodec->libraryName : "";
+    const QString profile = limited ? libraryName + ":limited" : libraryName;
+
+    // yuv420p frames; decoder and filter queues hold roughly half a second of them
+    const double frameMb = metadata.width * metadata.height * 1.5 / (1024 * 1024);
+    const double queuedFrames = qMax(8.0, metadata.frameRate * 0.5);
+    const double formulaMb = baseProcessMb + frameMb * (queuedFrames + bufferedFramesFor(libraryName, limited));
+
+    return Estimate {
+        .profile = profile,
+        .formulaMb = formulaMb,
+        .peakMb = formulaMb * corrections.value(profile, 1.0),
+    };
+}
+
+QString MemoryModel::MemoryLimitParams(const Codec& videoCodec) const
+{
+    const QString& name = videoCodec.libraryName;
+
+    if (name.startsWith("libx264"))
+        return "-threads 2 -rc-lookahead 10";
+
+    if (name == "libx265")
+        return "-threads 2 -x265-params rc-lookahead=10:frame-threads=1";
+
+    if (name == "libaom-av1" || name.startsWith("libvpx"))
+        return "-threads 2 -lag-in-frames 10";
+
+    if (name == "libsvtav1")
+        return "-svtav1-params lookahead=10";
+
+    if (name == "copy")
+        return "";
+
+    return "-threads 2";
+}
+
+void MemoryModel::Record(const Estimate& estimate, double measuredPeakMb)
+{
+    if (estimate.formulaMb <= 0 || measuredPeakMb <= 0)
+        return;
+
+    const double ratio = measuredPeakMb / estimate.formulaMb;
+
+    if (!corrections.contains(estimate.profile))
+    {
+        corrections.insert(estimate.profile, ratio);
+        return;
+    }
+
+    double& correction = corrections[estimate.profile];
+    correction = correction * (1 - feedbackWeight) + ratio * feedbackWeight;
+}
+
+double MemoryModel::bufferedFramesFor(const QString& libraryName, bool limited) const
+{
+    if (libraryName.isEmpty() || libraryName == "copy")
+        return 0;
+
+    // lookahead + reference frames + frame threads, as configured by each encoder's defaults
+    if (libraryName.startsWith("libx264"))
+        return limited ? 20 : 60;
+
+    if (libraryName == "libx265")
+        return limited ? 25 : 90;
+
+    if (libraryName == "libaom-av1")
+        return limited ? 20 : 80;
+
+    if (libraryName == "libsvtav1")
+        return limited ? 30 : 140;
+
+    if (libraryName.startsWith("libvpx"))
+        return limited ? 15 : 40;
+
+    // hardware encoders keep their frames in video memory
+    static const QStringList hardwareSuffixes { "_nvenc", "_qsv", "_amf", "_mf", "_vaapi", "_videotoolbox" };
+    for (const QString& suffix : hardwareSuffixes)
+    {
+        if (libraryName.endsWith(suffix))
+            return 8;
+    }
+
+    return 10;
+}
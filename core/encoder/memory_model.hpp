@@ -0,0 +1,41 @@
+#ifndef MEMORY_MODEL_H
+#define MEMORY_MODEL_H
+
+#include "core/formats/codec.hpp"
+#include "core/formats/metadata.hpp"
+
+#include <QHash>
+#include <QString>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Estimates the peak resident memory of an FFmpeg encoding job.
+//! \details Estimates start from a per-codec count of buffered frames (lookahead, references, frame threads) and are
+//! corrected over time by feeding back the peak memory that was actually measured for similar jobs.
+//!
+class MemoryModel
+{
+public:
+    struct Estimate
+    {
+        QString profile;
+        double formulaMb = 0;
+        double peakMb = 0;
+    };
+
+    [[nodiscard]] Estimate EstimatePeak(const Metadata& metadata, const optional<const Codec>& videoCodec, bool limited = false) const;
+    [[nodiscard]] QString MemoryLimitParams(const Codec& videoCodec) const;
+    void Record(const Estimate& estimate, double measuredPeakMb);
+
+private:
+    [[nodiscard]] double bufferedFramesFor(const QString& libraryName, bool limited) const;
+
+    const double baseProcessMb = 80;
+    const double feedbackWeight = 0.3;
+
+    QHash<QString, double> corrections;
+};
+
+#endif
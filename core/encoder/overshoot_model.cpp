@@ -0,0 +1,61 @@
+#include "overshoot_model.hpp"
+
+#include <QStringList>
+#include <cmath>
+#include <utility>
+
+OvershootModel::OvershootModel(std::shared_ptr<Settings> history)
+    : history(std::move(history))
+{
+    for (const QString& profile : this->history->keysInGroup(group))
+    {
+        const QStringList values = this->history->get(group + "/" + profile).toStringList();
+        if (values.size() != 2)
+            continue;
+
+        entries.insert(profile, { .logRatio = values[0].toDouble(), .samples = values[1].toInt() });
+    }
+}
+
+OvershootModel::Correction OvershootModel::CorrectionFor(const Codec& codec, const Container& container, double outputHeight) const
+{
+    const QString profile = QStringList { codec.libraryName, container.formatName, resolutionClass(outputHeight) }.join('.');
+
+    if (!entries.contains(profile))
+        return { .profile = profile };
+
+    const double factor = std::exp(entries[profile].logRatio);
+    return { .profile = profile, .factor = qBound(1 / maxCorrection, factor, maxCorrection) };
+}
+
+void OvershootModel::Record(const Correction& correction, double intendedKbps, double actualKbps)
+{
+    if (intendedKbps <= 0 || actualKbps <= 0)
+        return;
+
+    // the ratio this job would have had without its correction
+    const double ratio = actualKbps / intendedKbps * correction.factor;
+
+    Entry& entry = entries[correction.profile];
+    entry.samples++;
+    entry.logRatio += (std::log(ratio) - entry.logRatio) * qMax(1.0 / entry.samples, minFeedbackWeight);
+
+    history->Set(group + "/" + correction.profile, QStringList { QString::number(entry.logRatio), QString::number(entry.samples) });
+}
+
+QString OvershootModel::resolutionClass(double height)
+{
+    if (height <= 0)
+        return "audio";
+
+    if (height <= 480)
+        return "sd";
+
+    if (height <= 720)
+        return "hd";
+
+    if (height <= 1080)
+        return "fhd";
+
+    return "uhd";
+}
@@ -0,0 +1,51 @@
+#ifndef OVERSHOOT_MODEL_H
+#define OVERSHOOT_MODEL_H
+
+#include "core/formats/codec.hpp"
+#include "core/formats/container.hpp"
+#include "core/settings/settings.hpp"
+
+#include <QHash>
+#include <QString>
+#include <di.hpp>
+#include <memory>
+
+//!
+//! \brief Learns how far the output size lands from the requested size for similar jobs.
+//! \details Jobs are grouped by codec, container and resolution class. For each group, the ratio between the actual
+//! and the requested size is averaged over past jobs, and the next job's bitrate is divided by it. The history is
+//! persisted so that the size target converges across sessions.
+//!
+class OvershootModel
+{
+public:
+    struct Correction
+    {
+        QString profile;
+        double factor = 1; // expected actual size per requested size, before correcting
+    };
+
+    BOOST_DI_INJECT(OvershootModel, (named = di_history) std::shared_ptr<Settings> history);
+
+    [[nodiscard]] Correction CorrectionFor(const Codec& codec, const Container& container, double outputHeight) const;
+    void Record(const Correction& correction, double intendedKbps, double actualKbps);
+
+private:
+    struct Entry
+    {
+        double logRatio = 0;
+        int samples = 0;
+    };
+
+    [[nodiscard]] static QString resolutionClass(double height);
+
+    const QString group = "Overshoot";
+    // the first jobs are averaged equally, later ones with a fixed weight to follow changes in the encoder
+    const double minFeedbackWeight = 0.2;
+    const double maxCorrection = 2;
+
+    std::shared_ptr<Settings> history;
+    QHash<QString, Entry> entries;
+};
+
+#endif
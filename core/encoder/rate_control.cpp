@@ -0,0 +1,157 @@
+#include "rate_control.hpp"
+
+#include <QList>
+
+namespace
+{
+class OpusRateControl final : public RateControlStrategy
+{
+public:
+    double overshootFraction() const override { return 0.03; }
+    double minBitrateKbps(int channels) const override { return 6 * channels; }
+    double maxBitrateKbps(int channels) const override { return 256 * channels; }
+    double transparentBitrateKbps(int channels) const override { return 96 * channels; }
+    double packetsPerSecond(double) const override { return 50; } // 20 ms frames
+};
+
+class AacRateControl final : public RateControlStrategy
+{
+public:
+    double overshootFraction() const override { return 0.01; }
+    double minBitrateKbps(int channels) const override { return 8 * channels; }
+    double maxBitrateKbps(int channels) const override { return 256 * channels; }
+    double transparentBitrateKbps(int channels) const override { return 128 * channels; }
+    double packetsPerSecond(double) const override { return 48000.0 / 1024; }
+};
+
+class Mp3RateControl final : public RateControlStrategy
+{
+public:
+    // LAME encodes at a constant bitrate unless told otherwise
+    double overshootFraction() const override { return 0; }
+    double minBitrateKbps(int) const override { return 8; }
+    double maxBitrateKbps(int) const override { return 320; }
+    double transparentBitrateKbps(int channels) const override { return qMin(160 * channels, 320); }
+    double packetsPerSecond(double) const override { return 44100.0 / 1152; }
+
+    double supportedBitrateKbps(double bitrateKbps) const override
+    {
+        // LAME snaps any other bitrate to the nearest allowed one, which may be above the request
+        static const QList<double> allowed { 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 };
+
+        double supported = allowed.first();
+        for (const double bitrate : allowed)
+        {
+            if (bitrate <= bitrateKbps)
+                supported = bitrate;
+        }
+
+        return supported;
+    }
+};
+
+class VideoRateControl final : public RateControlStrategy
+{
+public:
+    explicit VideoRateControl(double overshootFraction)
+        : overshoot(overshootFraction)
+    {
+    }
+
+    double overshootFraction() const override { return overshoot; }
+
+private:
+    const double overshoot;
+};
+
+class ConfiguredRateControl final : public RateControlStrategy
+{
+public:
+    ConfiguredRateControl(const QSharedPointer<const RateControlStrategy>& base, const RateControlRegistry::Overrides& overrides)
+        : base(base)
+        , overrides(overrides)
+    {
+    }
+
+    double overshootFraction() const override { return overrides.overshootFraction.value_or(base->overshootFraction()); }
+    double minBitrateKbps(int channels) const override { return overrides.minBitrateKbps.value_or(base->minBitrateKbps(channels)); }
+    double maxBitrateKbps(int channels) const override { return overrides.maxBitrateKbps.value_or(base->maxBitrateKbps(channels)); }
+
+    double transparentBitrateKbps(int channels) const override
+    {
+        return qMin(base->transparentBitrateKbps(channels), maxBitrateKbps(channels));
+    }
+
+    double packetsPerSecond(double frameRate) const override
+    {
+        return overrides.packetsPerSecond.value_or(base->packetsPerSecond(frameRate));
+    }
+
+    double supportedBitrateKbps(double bitrateKbps) const override { return base->supportedBitrateKbps(bitrateKbps); }
+
+private:
+    const QSharedPointer<const RateControlStrategy> base;
+    const RateControlRegistry::Overrides overrides;
+};
+
+// bytes the container adds around every packet, including amortized index entries
+double packetOverheadBytes(const Container& container)
+{
+    const QString& format = container.formatName;
+
+    if (format == "matroska" || format == "webm")
+        return 10;
+
+    if (format == "mp4" || format == "mov" || format == "ipod")
+        return 8;
+
+    if (format == "adts")
+        return 7;
+
+    if (format == "ogg" || format == "opus")
+        return 3;
+
+    return 0;
+}
+}
+
+double RateControlStrategy::containerOverheadKbps(const Container& container, double frameRate) const
+{
+    return packetOverheadBytes(container) * packetsPerSecond(frameRate) * 8 / 1000;
+}
+
+RateControlRegistry::RateControlRegistry()
+    : defaultStrategy(QSharedPointer<RateControlStrategy>::create())
+{
+    const auto opus = QSharedPointer<OpusRateControl>::create();
+    const auto aac = QSharedPointer<AacRateControl>::create();
+    const auto x264 = QSharedPointer<VideoRateControl>::create(0.03);
+
+    Register("libopus", opus);
+    Register("opus", opus);
+    Register("aac", aac);
+    Register("libfdk_aac", aac);
+    Register("libmp3lame", QSharedPointer<Mp3RateControl>::create());
+    Register("libx264", x264);
+    Register("libx264rgb", x264);
+    // libvpx and the AV1 encoders treat the bitrate as a loose long-term target
+    Register("libvpx-vp9", QSharedPointer<VideoRateControl>::create(0.05));
+    Register("libaom-av1", QSharedPointer<VideoRateControl>::create(0.04));
+    Register("libsvtav1", QSharedPointer<VideoRateControl>::create(0.06));
+}
+
+void RateControlRegistry::Register(const QString& libraryName, const QSharedPointer<const RateControlStrategy>& strategy)
+{
+    strategies.insert(libraryName, strategy);
+}
+
+void RateControlRegistry::Register(const QString& libraryName, const Overrides& overrides)
+{
+    const QSharedPointer<const RateControlStrategy> base = strategies.value(overrides.basedOn, strategies.value(libraryName, defaultStrategy));
+    Register(libraryName, QSharedPointer<ConfiguredRateControl>::create(base, overrides));
+}
+
+const RateControlStrategy& RateControlRegistry::forCodec(const Codec& codec) const
+{
+    return *strategies.value(codec.libraryName, defaultStrategy);
+}
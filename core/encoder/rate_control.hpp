@@ -0,0 +1,69 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include "core/formats/codec.hpp"
+#include "core/formats/container.hpp"
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <limits>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Describes how an encoder turns a requested bitrate into bytes on disk.
+//! \details The defaults describe a well-behaved average bitrate encoder. Codec-specific strategies override what
+//! their encoder does differently, such as overshooting the request, only accepting certain bitrates or muxing more
+//! packets per second.
+//!
+struct RateControlStrategy
+{
+    virtual ~RateControlStrategy() = default;
+
+    //! Fraction by which the encoder's output tends to exceed the requested average bitrate.
+    [[nodiscard]] virtual double overshootFraction() const { return 0.02; }
+    [[nodiscard]] virtual double minBitrateKbps(int channels) const { return 0; }
+    [[nodiscard]] virtual double maxBitrateKbps(int channels) const { return std::numeric_limits<double>::max(); }
+    //! Bitrate past which more bits are no longer audible, used as the top of the audio quality scale.
+    [[nodiscard]] virtual double transparentBitrateKbps(int channels) const { return maxBitrateKbps(channels); }
+    //! Video encoders write one packet per frame, audio encoders one per fixed-size block of samples.
+    [[nodiscard]] virtual double packetsPerSecond(double frameRate) const { return frameRate > 0 ? frameRate : 50; }
+    //! Rounds down to a bitrate the encoder accepts as is, instead of letting it pick the nearest one.
+    [[nodiscard]] virtual double supportedBitrateKbps(double bitrateKbps) const { return bitrateKbps; }
+
+    [[nodiscard]] double bitrateForTargetKbps(double targetKbps) const { return targetKbps / (1 + overshootFraction()); }
+    [[nodiscard]] double containerOverheadKbps(const Container& container, double frameRate = 0) const;
+};
+
+//!
+//! \brief Looks up the rate control strategy of a codec by its library name.
+//! \details Strategies for the common software encoders ship built in. Codecs without one get the default
+//! strategy, and more can be registered in code or described in the configuration as overrides of an existing one.
+//!
+class RateControlRegistry
+{
+public:
+    struct Overrides
+    {
+        QString basedOn;
+        optional<double> overshootFraction;
+        optional<double> minBitrateKbps;
+        optional<double> maxBitrateKbps;
+        optional<double> packetsPerSecond;
+    };
+
+    RateControlRegistry();
+
+    void Register(const QString& libraryName, const QSharedPointer<const RateControlStrategy>& strategy);
+    void Register(const QString& libraryName, const Overrides& overrides);
+
+    [[nodiscard]] const RateControlStrategy& forCodec(const Codec& codec) const;
+
+private:
+    const QSharedPointer<const RateControlStrategy> defaultStrategy;
+    QHash<QString, QSharedPointer<const RateControlStrategy>> strategies;
+};
+
+#endif
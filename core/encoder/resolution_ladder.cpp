@@ -0,0 +1,63 @@
+#include "resolution_ladder.hpp"
+
+optional<ResolutionLadder::Choice> ResolutionLadder::choose(const Metadata& metadata, const Codec& codec, double videoBitrateKbps, double speed) const
+{
+    if (metadata.width <= 0 || metadata.height <= 0 || metadata.frameRate <= 0 || videoBitrateKbps <= 0)
+        return {};
+
+    const double threshold = minBitsPerPixel(codec);
+    const double displayAspectRatio = metadata.aspectRatioX / metadata.aspectRatioY;
+    const double sourceFrameRate = metadata.frameRate * speed;
+
+    const auto bitsPerPixel = [videoBitrateKbps](double width, double height, double frameRate)
+    {
+        return videoBitrateKbps * 1000 / (width * height * frameRate);
+    };
+
+    if (bitsPerPixel(metadata.width, metadata.height, sourceFrameRate) >= threshold)
+        return {};
+
+    // high frame rates are the cheapest thing to give up, so try the source resolution at a capped rate first
+    QList<Rung> candidates { { static_cast<int>(metadata.height), qMin(sourceFrameRate, 30.0) } };
+    for (const Rung& rung : rungs)
+    {
+        if (rung.height < metadata.height)
+            candidates.append({ rung.height, qMin(sourceFrameRate, rung.frameRate) });
+    }
+
+    Choice choice {};
+    for (const Rung& candidate : candidates)
+    {
+        // keep widths even, as most encoders require for 4:2:0 chroma subsampling
+        const int width = qRound(candidate.height * displayAspectRatio / 2) * 2;
+        choice = { width, candidate.height, candidate.frameRate };
+
+        if (bitsPerPixel(width, candidate.height, candidate.frameRate) >= threshold)
+            break;
+    }
+
+    return choice;
+}
+
+double ResolutionLadder::minBitsPerPixel(const Codec& codec) const
+{
+    const QString& name = codec.libraryName;
+
+    if (name == "libaom-av1" || name == "libsvtav1")
+        return 0.02;
+
+    if (name.startsWith("av1_"))
+        return 0.025;
+
+    if (name == "libx265" || name.startsWith("libvpx-vp9"))
+        return 0.028;
+
+    if (name.startsWith("hevc_") || name.startsWith("vp9_"))
+        return 0.035;
+
+    if (name.startsWith("libx264"))
+        return 0.04;
+
+    // hardware H.264 and older codecs
+    return 0.05;
+}
@@ -0,0 +1,51 @@
+#ifndef RESOLUTION_LADDER_H
+#define RESOLUTION_LADDER_H
+
+#include "core/formats/codec.hpp"
+#include "core/formats/metadata.hpp"
+
+#include <QList>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Picks a lower resolution and frame rate when a bitrate is too low for the source's pixel rate.
+//! \details Each codec needs a minimum amount of bits per pixel to produce a watchable picture. Below it, encoding every
+//! source pixel is both slow and wasteful, so the ladder steps down until the bitrate can feed what is left.
+//!
+class ResolutionLadder
+{
+public:
+    struct Rung
+    {
+        int height;
+        double frameRate;
+    };
+
+    struct Choice
+    {
+        int width;
+        int height;
+        double frameRate;
+    };
+
+    //! Returns nothing when the source itself gets enough bits per pixel.
+    [[nodiscard]] optional<Choice> choose(const Metadata& metadata, const Codec& codec, double videoBitrateKbps, double speed = 1) const;
+    [[nodiscard]] double minBitsPerPixel(const Codec& codec) const;
+
+private:
+    const QList<Rung> rungs {
+        { 1080, 30 },
+        { 720, 30 },
+        { 540, 30 },
+        { 480, 30 },
+        { 360, 30 },
+        { 360, 24 },
+        { 240, 24 },
+        { 240, 15 },
+        { 144, 15 },
+    };
+};
+
+#endif
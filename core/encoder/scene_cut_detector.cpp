@@ -0,0 +1,166 @@
+#include "scene_cut_detector.hpp"
+
+#include <QProcess>
+#include <QStringList>
+#include <cstring>
+
+SceneCutDetector::SceneCutDetector(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache, KeyframeIndex& keyframeIndex)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+    , keyframeIndex(keyframeIndex)
+{
+}
+
+QFuture<QList<double>> SceneCutDetector::Detect(const QString& inputPath, const Metadata& metadata)
+{
+    if (const QVariant cached = cache.get(analysis, inputPath); cached.isValid())
+        return QtFuture::makeReadyValueFuture(deserialize(cached.toString()));
+
+    if (metadata.width <= 0 || metadata.height <= 0)
+        return QtFuture::makeReadyValueFuture(QList<double> {});
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (pending.contains(identity))
+        return pending[identity]->promise.future();
+
+    const auto scan = QSharedPointer<Scan>::create();
+    scan->identity = identity;
+    scan->inputPath = inputPath;
+    // frames are resampled to this rate while decoding, so any rate keeps the timing right
+    scan->frameRate = metadata.frameRate > 0 ? metadata.frameRate : nominalFrameRate;
+    scan->promise.start();
+    pending.insert(identity, scan);
+
+    StartDecode(scan, metadata);
+
+    keyframeIndex.Load(inputPath).then(this, [=, this](const KeyframeIndex::Map& keyframes)
+    {
+        scan->keyframes = keyframes;
+        scan->hasFailed = scan->hasFailed || keyframes.isEmpty();
+        EndJob(scan);
+    });
+
+    return scan->promise.future();
+}
+
+void SceneCutDetector::StartDecode(const QSharedPointer<Scan>& scan, const Metadata& metadata)
+{
+    // a constant frame rate lets the frame count stand in for the timestamps
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -loglevel error -i "%1" -map 0:v:0 -vf scale=%2:%3:flags=fast_bilinear,format=gray -fps_mode cfr -r %4 -an -sn -f rawvideo -)")
+                                .arg(scan->inputPath)
+                                .arg(planeWidth)
+                                .arg(planeHeight)
+                                .arg(QString::number(scan->frameRate));
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(metadata, {}) });
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error != QProcess::FailedToStart)
+            return;
+
+        scan->hasFailed = true;
+        EndJob(scan);
+    });
+
+    connect(ffmpeg, &QProcess::readyReadStandardOutput, this, [=, this]
+    {
+        const qsizetype planeSize = static_cast<qsizetype>(planeWidth) * planeHeight;
+        scan->partialPlane.append(ffmpeg->readAllStandardOutput());
+
+        qsizetype offset = 0;
+        for (; offset + planeSize <= scan->partialPlane.size(); offset += planeSize)
+            Compare(*scan, reinterpret_cast<const std::uint8_t*>(scan->partialPlane.constData() + offset));
+
+        scan->partialPlane.remove(0, offset);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0)
+            scan->hasFailed = true;
+
+        EndJob(scan);
+    });
+}
+
+void SceneCutDetector::Compare(Scan& scan, const std::uint8_t* plane)
+{
+    const std::size_t planeSize = static_cast<std::size_t>(planeWidth) * planeHeight;
+    const FrameDifference::Histogram histogram = FrameDifference::histogram(plane, planeSize);
+
+    if (!scan.previous.empty())
+    {
+        const double difference = static_cast<double>(FrameDifference::fastestSad()(scan.previous.data(), plane, planeSize)) / planeSize;
+        const double histogramDistance = FrameDifference::histogramDistance(scan.previousHistogram, histogram, planeSize);
+        const double seconds = scan.frames / scan.frameRate;
+        const double sceneSeconds = seconds - (scan.cuts.isEmpty() ? 0 : scan.cuts.last());
+
+        if (histogramDistance >= minHistogramDistance && difference >= qMax(minDifference, scan.averageDifference * averageMultiplier)
+            && sceneSeconds >= minSceneSeconds)
+            scan.cuts.append(seconds);
+
+        scan.averageDifference += (difference - scan.averageDifference) * averageWeight;
+    }
+    else
+    {
+        scan.previous.resize(planeSize);
+    }
+
+    std::memcpy(scan.previous.data(), plane, planeSize);
+    scan.previousHistogram = histogram;
+    scan.frames++;
+}
+
+void SceneCutDetector::EndJob(const QSharedPointer<Scan>& scan)
+{
+    if (--scan->remaining > 0)
+        return;
+
+    pending.remove(scan->identity);
+
+    QList<double> cuts;
+    if (!scan->hasFailed)
+    {
+        cuts = snapped(scan->cuts, scan->keyframes);
+        cache.Set(analysis, scan->inputPath, serialize(cuts));
+    }
+
+    scan->promise.addResult(cuts);
+    scan->promise.finish();
+}
+
+QList<double> SceneCutDetector::snapped(const QList<double>& cuts, const KeyframeIndex::Map& keyframes)
+{
+    QList<double> result;
+
+    for (const double cut : cuts)
+    {
+        const optional<KeyframeIndex::Keyframe> nearest = keyframes.nearest(cut);
+
+        // the first keyframe starts the input rather than a scene, and neighbouring cuts can share a keyframe
+        if (nearest.has_value() && nearest->seconds > keyframes.begin()->seconds && (result.isEmpty() || result.last() < nearest->seconds))
+            result.append(nearest->seconds);
+    }
+
+    return result;
+}
+
+QString SceneCutDetector::serialize(const QList<double>& seconds)
+{
+    QStringList values;
+    for (const double value : seconds)
+        values.append(QString::number(value));
+
+    return values.join(' ');
+}
+
+QList<double> SceneCutDetector::deserialize(const QString& seconds)
+{
+    QList<double> result;
+    for (const QString& value : seconds.split(' ', Qt::SkipEmptyParts))
+        result.append(value.toDouble());
+
+    return result;
+}
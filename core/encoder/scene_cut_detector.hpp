@@ -0,0 +1,82 @@
+#ifndef SCENE_CUT_DETECTOR_H
+#define SCENE_CUT_DETECTOR_H
+
+#include "core/formats/metadata.hpp"
+#include "analysis_cache.hpp"
+#include "frame_difference.hpp"
+#include "job_scheduler.hpp"
+#include "keyframe_index.hpp"
+#include "memory_model.hpp"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <vector>
+
+//!
+//! \brief Finds where the scenes of an input change, as points to split it at.
+//! \details FFmpeg decodes a small grayscale version of the video and pipes the raw planes back, where consecutive
+//! frames are compared in-process with the FrameDifference kernels. A cut needs both a shifted brightness histogram and
+//! a difference well above the recent average, which keeps flashes and fast pans from counting. The cuts are moved to
+//! the nearest keyframe, looked up in the KeyframeIndex of the input, and cached per file.
+//!
+class SceneCutDetector final : public QObject
+{
+public:
+    explicit SceneCutDetector(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache, KeyframeIndex& keyframeIndex);
+
+    //! Resolves to the keyframe timestamps that start a new scene, in ascending seconds. Empty when there are none, or
+    //! when the input could not be analyzed.
+    QFuture<QList<double>> Detect(const QString& inputPath, const Metadata& metadata);
+
+private:
+    struct Scan
+    {
+        QString identity;
+        QString inputPath;
+        double frameRate = 0;
+        QByteArray partialPlane;
+        std::vector<std::uint8_t> previous;
+        FrameDifference::Histogram previousHistogram {};
+        qint64 frames = 0;
+        double averageDifference = 0;
+        QList<double> cuts;
+        KeyframeIndex::Map keyframes;
+        int remaining = 2;
+        bool hasFailed = false;
+        QPromise<QList<double>> promise;
+    };
+
+    void StartDecode(const QSharedPointer<Scan>& scan, const Metadata& metadata);
+    void Compare(Scan& scan, const std::uint8_t* plane);
+    void EndJob(const QSharedPointer<Scan>& scan);
+
+    [[nodiscard]] static QList<double> snapped(const QList<double>& cuts, const KeyframeIndex::Map& keyframes);
+    [[nodiscard]] static QString serialize(const QList<double>& seconds);
+    [[nodiscard]] static QList<double> deserialize(const QString& seconds);
+
+    const QString analysis = "SceneCuts";
+    // small enough that decoding dominates, large enough that a cut still shows
+    const int planeWidth = 160;
+    const int planeHeight = 90;
+    const double nominalFrameRate = 30;
+    const double minHistogramDistance = 0.3;
+    // mean absolute difference per pixel, out of 255
+    const double minDifference = 8;
+    const double averageMultiplier = 3;
+    const double averageWeight = 0.1;
+    const double minSceneSeconds = 1;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    KeyframeIndex& keyframeIndex;
+    QHash<QString, QSharedPointer<Scan>> pending;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "smart_cut.hpp"
+
+bool SmartCutPlanner::canCut(const EncoderOptions& options) const
+{
+    const bool isTrimmed = options.trimStartSeconds.has_value() || options.trimEndSeconds.has_value();
+    const bool copiesVideo = options.videoCodec.has_value() && options.videoCodec->libraryName == "copy";
+    // re-encoded audio would leave encoder delay at every joint
+    const bool copiesAudio = !options.audioCodec.has_value() || options.audioCodec->libraryName == "copy";
+    const bool isRetimed = options.speed.has_value() || options.fps.has_value();
+    // the parts are joined into a single file, which a segmenter would have to split up again
+    const bool isStreamed = options.streamingFormat.has_value();
+
+    return isTrimmed && copiesVideo && copiesAudio && !isRetimed && !isStreamed && edgeEncoders.contains(options.inputMetadata.videoCodec)
+        && options.customArguments.value_or("").trimmed().isEmpty();
+}
+
+QList<SmartCutPlanner::Segment> SmartCutPlanner::segmentsFor(double startSeconds, double endSeconds, const KeyframeIndex::Map& keyframes, double frameRate) const
+{
+    const optional<KeyframeIndex::Keyframe> first = keyframes.atOrAfter(startSeconds);
+    const optional<KeyframeIndex::Keyframe> last = keyframes.atOrBefore(endSeconds);
+
+    if (!first.has_value() || !last.has_value() || first->seconds >= last->seconds)
+        return { { .startSeconds = startSeconds, .durationSeconds = endSeconds - startSeconds } };
+
+    // an edge shorter than a frame is the keyframe landing on the cut itself
+    const double frameSeconds = 1 / (frameRate > 0 ? frameRate : nominalFrameRate);
+    QList<Segment> segments;
+
+    if (first->seconds - startSeconds >= frameSeconds / 2)
+        segments.append({ .startSeconds = startSeconds, .durationSeconds = first->seconds - startSeconds });
+
+    segments.append({ .startSeconds = first->seconds, .durationSeconds = last->seconds - first->seconds, .isCopied = true });
+
+    if (endSeconds - last->seconds >= frameSeconds / 2)
+        segments.append({ .startSeconds = last->seconds, .durationSeconds = endSeconds - last->seconds });
+
+    return segments;
+}
+
+SmartCutPlanner::EdgeEncoder SmartCutPlanner::edgeEncoderFor(const QString& codecName) const
+{
+    return edgeEncoders.value(codecName);
+}
@@ -0,0 +1,53 @@
+#ifndef SMART_CUT_H
+#define SMART_CUT_H
+
+#include "encoder_options.hpp"
+#include "keyframe_index.hpp"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+//!
+//! \brief Plans frame-accurate trims of passthrough video that only re-encode what they have to.
+//! \details Copied video can only start on a keyframe. The trimmed part is therefore split at the first and last
+//! keyframes inside it: the groups of pictures in between are copied as they are, and only the partial ones at both
+//! edges are re-encoded, with the codec of the input so that the parts can be concatenated without decoding anything.
+//! Cutting a few seconds out of hours of video takes about as long as re-encoding those few seconds.
+//!
+class SmartCutPlanner
+{
+public:
+    struct Segment
+    {
+        double startSeconds = 0;
+        double durationSeconds = 0;
+        bool isCopied = false;
+    };
+
+    struct EdgeEncoder
+    {
+        QString params;
+        // one that repeats the parameter sets in-band, so that re-encoded and copied parts can follow each other
+        QString intermediateFormat;
+    };
+
+    //! Whether the options copy the video of a trimmed input the concatenated parts can stay compatible with.
+    [[nodiscard]] bool canCut(const EncoderOptions& options) const;
+    //! Parts of the kept range, in order. A range without a whole group of pictures is re-encoded in one part.
+    [[nodiscard]] QList<Segment> segmentsFor(double startSeconds, double endSeconds, const KeyframeIndex::Map& keyframes, double frameRate) const;
+    [[nodiscard]] EdgeEncoder edgeEncoderFor(const QString& codecName) const;
+
+private:
+    // stands in for a rate the input does not report, to tell a keyframe on the cut from one a frame or more away
+    const double nominalFrameRate = 30;
+    // edges are short, so they can afford a quality the copied parts will not stand out from
+    const QHash<QString, EdgeEncoder> edgeEncoders {
+        { "h264", { "-c:v libx264 -crf 16 -preset veryfast", "mpegts" } },
+        { "hevc", { "-c:v libx265 -crf 18 -preset veryfast", "mpegts" } },
+        { "vp9", { "-c:v libvpx-vp9 -crf 20 -b:v 0 -deadline realtime -cpu-used 8", "matroska" } },
+        { "av1", { "-c:v libsvtav1 -crf 24 -preset 10", "matroska" } },
+    };
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "thumbnail_generator.hpp"
+
+#include "downscale.hpp"
+
+#include <QPainter>
+#include <QProcess>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+ThumbnailGenerator::ThumbnailGenerator(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<QImage> ThumbnailGenerator::Generate(const QString& inputPath, const Metadata& metadata)
+{
+    if (metadata.videoCodec.isEmpty())
+        return QtFuture::makeReadyValueFuture(QImage());
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (loaded.contains(identity))
+        return QtFuture::makeReadyValueFuture(loaded[identity]);
+
+    if (const QImage cached(cache.filePathFor(analysis, inputPath), "JPG"); !cached.isNull())
+    {
+        loaded.insert(identity, cached);
+        return QtFuture::makeReadyValueFuture(cached);
+    }
+
+    if (pending.contains(identity))
+        return pending[identity]->promise.future();
+
+    // a still picture, or a stream that does not tell its length, has a single thumbnail
+    const qsizetype count = metadata.durationSeconds > 0 ? thumbnailCount : 1;
+
+    const auto strip = QSharedPointer<Strip>::create();
+    strip->identity = identity;
+    strip->inputPath = inputPath;
+    strip->thumbnails.resize(count);
+    strip->remaining = count;
+    strip->promise.start();
+    pending.insert(identity, strip);
+
+    // the middle of each equal part, so that neither the first nor the last frame of the input is picked
+    for (qsizetype i = 0; i < count; i++)
+        StartThumbnail(strip, metadata, i, metadata.durationSeconds * (i + 0.5) / count);
+
+    return strip->promise.future();
+}
+
+void ThumbnailGenerator::StartThumbnail(const QSharedPointer<Strip>& strip, const Metadata& metadata, qsizetype index, double seconds)
+{
+    // without an accurate seek, the keyframe the demuxer lands on is output as is instead of decoding up to the time
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -loglevel error -skip_frame nokey -noaccurate_seek -ss %1 -i "%2" )"
+                                    R"(-map 0:v:0 -frames:v 1 -an -sn -c:v pam -pix_fmt rgba -f image2pipe -)")
+                                .arg(QString::number(seconds), strip->inputPath);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(metadata, {}), .isInteractive = true });
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            EndThumbnail(strip);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0)
+        {
+            EndThumbnail(strip);
+            return;
+        }
+
+        QtConcurrent::run(&ThumbnailGenerator::thumbnailOf, ffmpeg->readAllStandardOutput(), thumbnailHeight)
+            .then(this, [=, this](const QImage& thumbnail)
+            {
+                strip->thumbnails[index] = thumbnail;
+                EndThumbnail(strip);
+            });
+    });
+}
+
+void ThumbnailGenerator::EndThumbnail(const QSharedPointer<Strip>& strip)
+{
+    if (--strip->remaining > 0)
+        return;
+
+    pending.remove(strip->identity);
+
+    const QImage image = composed(strip->thumbnails);
+    if (!image.isNull())
+    {
+        // thumbnails that failed are tried again next time, in case the input was still being written
+        if (std::ranges::none_of(strip->thumbnails, &QImage::isNull))
+            image.save(cache.filePathFor(analysis, strip->inputPath), "JPG", 85);
+
+        loaded.insert(strip->identity, image);
+    }
+
+    strip->promise.addResult(image);
+    strip->promise.finish();
+}
+
+QImage ThumbnailGenerator::thumbnailOf(const QByteArray& picture, int height)
+{
+    const qsizetype headerEnd = picture.indexOf("ENDHDR\n");
+    if (!picture.startsWith("P7\n") || headerEnd < 0)
+        return {};
+
+    int width = 0;
+    int sourceHeight = 0;
+    int depth = 0;
+
+    for (const QByteArray& line : picture.first(headerEnd).split('\n'))
+    {
+        const QList<QByteArray> fields = line.split(' ');
+        if (fields.size() != 2)
+            continue;
+
+        if (fields[0] == "WIDTH")
+            width = fields[1].toInt();
+        else if (fields[0] == "HEIGHT")
+            sourceHeight = fields[1].toInt();
+        else if (fields[0] == "DEPTH")
+            depth = fields[1].toInt();
+    }
+
+    const qsizetype pixelsStart = headerEnd + qstrlen("ENDHDR\n");
+    if (width <= 0 || sourceHeight <= 0 || depth != 4 || picture.size() - pixelsStart < static_cast<qsizetype>(width) * sourceHeight * 4)
+        return {};
+
+    // wraps the piped bytes, which outlive it since every halving copies into a new image
+    QImage frame(reinterpret_cast<const uchar*>(picture.constData() + pixelsStart), width, sourceHeight, width * 4, QImage::Format_RGBA8888);
+
+    // halving is exact and vectorized, so the smooth scaling that follows only has to cover less than a factor of 2
+    const Downscale::HalveKernel halve = Downscale::fastestHalve();
+    while (frame.height() / 2 >= height && frame.width() >= 2)
+    {
+        QImage halved(frame.width() / 2, frame.height() / 2, QImage::Format_RGBA8888);
+        halve(frame.constBits(), frame.bytesPerLine(), halved.bits(), halved.bytesPerLine(), halved.width(), halved.height());
+        frame = halved;
+    }
+
+    return frame.scaledToHeight(height, Qt::SmoothTransformation);
+}
+
+QImage ThumbnailGenerator::composed(const QList<QImage>& thumbnails) const
+{
+    int width = 0;
+    for (const QImage& thumbnail : thumbnails)
+        width += thumbnail.width();
+
+    if (width == 0)
+        return {};
+
+    QImage strip(width, thumbnailHeight, QImage::Format_RGB32);
+    strip.fill(Qt::black);
+
+    QPainter painter(&strip);
+    int x = 0;
+
+    for (const QImage& thumbnail : thumbnails)
+    {
+        painter.drawImage(x, 0, thumbnail);
+        x += thumbnail.width();
+    }
+
+    return strip;
+}
@@ -0,0 +1,62 @@
+#ifndef THUMBNAIL_GENERATOR_H
+#define THUMBNAIL_GENERATOR_H
+
+#include "core/formats/metadata.hpp"
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+
+//!
+//! \brief Draws a strip of thumbnails spread over an input, to show what a file holds as soon as it is selected.
+//! \details Each thumbnail is a keyframe: FFmpeg seeks near an evenly spaced time and decodes the first keyframe it
+//! finds, skipping every other frame, so that a thumbnail costs about one decoded picture however long the input is.
+//! The keyframes are decoded by concurrent interactive jobs and come back as uncompressed pictures, which are halved
+//! in-process with the Downscale kernels. The strip is cached per file as an image next to the analysis cache.
+//!
+class ThumbnailGenerator final : public QObject
+{
+public:
+    explicit ThumbnailGenerator(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves to a null image when the input has no video, or none of it could be decoded.
+    QFuture<QImage> Generate(const QString& inputPath, const Metadata& metadata);
+
+private:
+    struct Strip
+    {
+        QString identity;
+        QString inputPath;
+        QList<QImage> thumbnails;
+        qsizetype remaining = 0;
+        QPromise<QImage> promise;
+    };
+
+    void StartThumbnail(const QSharedPointer<Strip>& strip, const Metadata& metadata, qsizetype index, double seconds);
+    void EndThumbnail(const QSharedPointer<Strip>& strip);
+
+    //! Reads a PAM picture of 4-byte pixels and scales it to the given height, halving it as far as it goes first.
+    [[nodiscard]] static QImage thumbnailOf(const QByteArray& picture, int height);
+    [[nodiscard]] QImage composed(const QList<QImage>& thumbnails) const;
+
+    const QString analysis = "Thumbnails";
+    const int thumbnailCount = 8;
+    const int thumbnailHeight = 72;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, QImage> loaded;
+    QHash<QString, QSharedPointer<Strip>> pending;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "trim_analyzer.hpp"
+
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+
+TrimAnalyzer::TrimAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache)
+    : scheduler(scheduler)
+    , memoryModel(memoryModel)
+    , cache(cache)
+{
+}
+
+QFuture<TrimAnalyzer::DeadIntervals> TrimAnalyzer::Analyze(const QString& inputPath, const Metadata& metadata, bool isInteractive)
+{
+    if (const QStringList cached = cache.get(analysis, inputPath).toStringList(); cached.size() == 2)
+        return QtFuture::makeReadyValueFuture(DeadIntervals { .silence = deserialize(cached[0]), .black = deserialize(cached[1]) });
+
+    if (metadata.durationSeconds <= 0)
+        return QtFuture::makeReadyValueFuture(DeadIntervals {});
+
+    const QString identity = AnalysisCache::identityOf(inputPath);
+    if (pending.contains(identity))
+    {
+        if (isInteractive)
+        {
+            for (QProcess* process : pending[identity]->processes)
+                scheduler.Prioritize(process);
+        }
+
+        return pending[identity]->promise.future();
+    }
+
+    const auto scan = QSharedPointer<Scan>::create();
+    scan->identity = identity;
+    scan->inputPath = inputPath;
+    scan->isInteractive = isInteractive;
+    scan->promise.start();
+    pending.insert(identity, scan);
+
+    const int chunks = qBound(1, static_cast<int>(metadata.durationSeconds / minChunkSeconds), maxChunks);
+    const double chunkSeconds = metadata.durationSeconds / chunks;
+    scan->remaining = chunks;
+
+    for (int i = 0; i < chunks; i++)
+        StartChunk(scan, metadata, i * chunkSeconds, chunkSeconds);
+
+    return scan->promise.future();
+}
+
+optional<TrimAnalyzer::Trim> TrimAnalyzer::trimFor(const DeadIntervals& dead, double durationSeconds, bool hasAudio, bool hasVideo) const
+{
+    if (durationSeconds <= 0 || (!hasAudio && !hasVideo))
+        return {};
+
+    QList<Interval> deadIntervals;
+    if (hasAudio && hasVideo)
+        deadIntervals = intersected(dead.silence, dead.black);
+    else
+        deadIntervals = hasAudio ? dead.silence : dead.black;
+
+    double startSeconds = 0;
+    double endSeconds = durationSeconds;
+
+    for (const Interval& interval : deadIntervals)
+    {
+        if (interval.endSeconds - interval.startSeconds < minDeadSeconds)
+            continue;
+
+        if (interval.startSeconds <= edgeToleranceSeconds)
+            startSeconds = qMax(startSeconds, interval.endSeconds - marginSeconds);
+
+        if (interval.endSeconds >= durationSeconds - edgeToleranceSeconds)
+            endSeconds = qMin(endSeconds, interval.startSeconds + marginSeconds);
+    }
+
+    // an input that is dead throughout is better encoded whole than not at all
+    if (endSeconds - startSeconds < minDeadSeconds || durationSeconds - (endSeconds - startSeconds) < minDeadSeconds)
+        return {};
+
+    return Trim { .startSeconds = startSeconds, .durationSeconds = endSeconds - startSeconds };
+}
+
+void TrimAnalyzer::StartChunk(const QSharedPointer<Scan>& scan, const Metadata& metadata, double startSeconds, double seconds)
+{
+    const bool hasAudio = !metadata.audioCodec.isEmpty();
+    const bool hasVideo = metadata.width > 0 && metadata.height > 0;
+
+    const QString audioParams = hasAudio ? QString("-af silencedetect=n=%1dB:d=%2").arg(noiseDb).arg(minDeadSeconds) : "-an";
+    const QString videoParams = hasVideo ? QString("-vf blackdetect=d=%1:pix_th=%2").arg(minDeadSeconds).arg(blackPixelThreshold) : "-vn";
+    const QString command = QString(R"(ffmpeg -hide_banner -nostats -ss %1 -t %2 -i "%3" %4 %5 -sn -f null -)")
+                                .arg(QString::number(startSeconds), QString::number(seconds), scan->inputPath, audioParams, videoParams);
+
+    QProcess* ffmpeg = scheduler.Submit({ .command = command, .memory = memoryModel.EstimatePeak(metadata, {}), .isInteractive = scan->isInteractive });
+    ffmpeg->setProcessChannelMode(QProcess::MergedChannels);
+    scan->processes.append(ffmpeg);
+
+    connect(ffmpeg, &QProcess::errorOccurred, this, [=, this](QProcess::ProcessError error)
+    {
+        if (error != QProcess::FailedToStart)
+            return;
+
+        scan->hasFailed = true;
+        EndChunk(scan);
+    });
+
+    connect(ffmpeg, &QProcess::finished, this, [=, this](const int exitCode)
+    {
+        if (exitCode != 0)
+        {
+            scan->hasFailed = true;
+            EndChunk(scan);
+            return;
+        }
+
+        const QString output(ffmpeg->readAll());
+
+        // timestamps restart at the seek point, and a stretch still going when the chunk ends runs up to its end
+        static const QRegularExpression silenceRegex(R"(silence_(start|end): (-?[0-9.]+))");
+        optional<double> silenceStart;
+        for (const QRegularExpressionMatch& match : silenceRegex.globalMatch(output))
+        {
+            const double seconds = startSeconds + qMax(0.0, match.captured(2).toDouble());
+
+            if (match.captured(1) == "start")
+            {
+                silenceStart = seconds;
+            }
+            else if (silenceStart.has_value())
+            {
+                scan->dead.silence.append({ *silenceStart, seconds });
+                silenceStart.reset();
+            }
+        }
+
+        if (silenceStart.has_value())
+            scan->dead.silence.append({ *silenceStart, startSeconds + seconds });
+
+        static const QRegularExpression blackRegex(R"(black_start:([0-9.]+) black_end:([0-9.]+))");
+        for (const QRegularExpressionMatch& match : blackRegex.globalMatch(output))
+            scan->dead.black.append({ startSeconds + match.captured(1).toDouble(), startSeconds + match.captured(2).toDouble() });
+
+        EndChunk(scan);
+    });
+}
+
+void TrimAnalyzer::EndChunk(const QSharedPointer<Scan>& scan)
+{
+    if (--scan->remaining > 0)
+        return;
+
+    pending.remove(scan->identity);
+
+    // a stretch cut in two by a chunk boundary is one stretch
+    DeadIntervals dead;
+    if (!scan->hasFailed)
+    {
+        dead = { .silence = merged(scan->dead.silence), .black = merged(scan->dead.black) };
+        cache.Set(analysis, scan->inputPath, QStringList { serialize(dead.silence), serialize(dead.black) });
+    }
+
+    scan->promise.addResult(dead);
+    scan->promise.finish();
+}
+
+QList<TrimAnalyzer::Interval> TrimAnalyzer::merged(QList<Interval> intervals)
+{
+    std::sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) { return a.startSeconds < b.startSeconds; });
+
+    // detection lags by a few frames on both sides of a boundary
+    const double gapSeconds = 0.1;
+
+    QList<Interval> result;
+    for (const Interval& interval : intervals)
+    {
+        if (!result.isEmpty() && interval.startSeconds <= result.last().endSeconds + gapSeconds)
+            result.last().endSeconds = qMax(result.last().endSeconds, interval.endSeconds);
+        else
+            result.append(interval);
+    }
+
+    return result;
+}
+
+QList<TrimAnalyzer::Interval> TrimAnalyzer::intersected(const QList<Interval>& a, const QList<Interval>& b)
+{
+    QList<Interval> result;
+
+    for (const Interval& first : a)
+    {
+        for (const Interval& second : b)
+        {
+            const double start = qMax(first.startSeconds, second.startSeconds);
+            const double end = qMin(first.endSeconds, second.endSeconds);
+
+            if (start < end)
+                result.append({ start, end });
+        }
+    }
+
+    return result;
+}
+
+QString TrimAnalyzer::serialize(const QList<Interval>& intervals)
+{
+    QStringList values;
+    for (const Interval& interval : intervals)
+        // fixed notation, as the exponent of a tiny value would bring a second minus sign into the pair
+        values.append(QString::number(interval.startSeconds, 'f', 6) + "-" + QString::number(interval.endSeconds, 'f', 6));
+
+    return values.join(' ');
+}
+
+QList<TrimAnalyzer::Interval> TrimAnalyzer::deserialize(const QString& intervals)
+{
+    QList<Interval> result;
+    for (const QString& value : intervals.split(' ', Qt::SkipEmptyParts))
+    {
+        const QStringList bounds = value.split('-');
+        if (bounds.size() == 2)
+            result.append({ bounds[0].toDouble(), bounds[1].toDouble() });
+    }
+
+    return result;
+}
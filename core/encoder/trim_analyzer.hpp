@@ -0,0 +1,98 @@
+#ifndef TRIM_ANALYZER_H
+#define TRIM_ANALYZER_H
+
+#include "core/formats/metadata.hpp"
+#include "analysis_cache.hpp"
+#include "job_scheduler.hpp"
+#include "memory_model.hpp"
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <optional>
+
+using std::optional;
+
+//!
+//! \brief Finds dead air and black frames at both ends of an input, so that the encode can skip them.
+//! \details The input is split into chunks that run silencedetect and blackdetect concurrently, and the stretches they
+//! report are stitched back together. What is dead depends on the streams being encoded, so the stretches themselves
+//! are cached per file and the trim is derived from them for each encode.
+//!
+class TrimAnalyzer final : public QObject
+{
+public:
+    struct Interval
+    {
+        double startSeconds = 0;
+        double endSeconds = 0;
+    };
+
+    struct DeadIntervals
+    {
+        QList<Interval> silence;
+        QList<Interval> black;
+    };
+
+    struct Trim
+    {
+        double startSeconds = 0;
+        double durationSeconds = 0;
+    };
+
+    explicit TrimAnalyzer(JobScheduler& scheduler, MemoryModel& memoryModel, AnalysisCache& cache);
+
+    //! Resolves to no stretches at all when the input could not be analyzed. An interactive analysis runs ahead of
+    //! anything queued, along with one of the same file that is already pending.
+    QFuture<DeadIntervals> Analyze(const QString& inputPath, const Metadata& metadata, bool isInteractive = false);
+
+    //! Keeps what lies between the dead ends, where dead means silent for audio and black for video, and both when
+    //! both are encoded. Nothing when there is barely anything to trim.
+    [[nodiscard]] optional<Trim> trimFor(const DeadIntervals& dead, double durationSeconds, bool hasAudio, bool hasVideo) const;
+
+private:
+    struct Scan
+    {
+        QString identity;
+        QString inputPath;
+        DeadIntervals dead;
+        QList<QPointer<QProcess>> processes;
+        bool isInteractive = false;
+        int remaining = 0;
+        bool hasFailed = false;
+        QPromise<DeadIntervals> promise;
+    };
+
+    void StartChunk(const QSharedPointer<Scan>& scan, const Metadata& metadata, double startSeconds, double seconds);
+    void EndChunk(const QSharedPointer<Scan>& scan);
+
+    [[nodiscard]] static QList<Interval> merged(QList<Interval> intervals);
+    [[nodiscard]] static QList<Interval> intersected(const QList<Interval>& a, const QList<Interval>& b);
+    [[nodiscard]] static QString serialize(const QList<Interval>& intervals);
+    [[nodiscard]] static QList<Interval> deserialize(const QString& intervals);
+
+    const QString analysis = "Trim";
+    const double noiseDb = -50;
+    const double blackPixelThreshold = 0.1;
+    const double minDeadSeconds = 1;
+    // chunks are long enough that starting each process stays negligible
+    const double minChunkSeconds = 120;
+    const int maxChunks = 8;
+    // dead stretches this close to an end count as touching it
+    const double edgeToleranceSeconds = 0.5;
+    // left on both sides of the kept part, so that it does not start or stop abruptly
+    const double marginSeconds = 0.25;
+
+    JobScheduler& scheduler;
+    MemoryModel& memoryModel;
+    AnalysisCache& cache;
+    QHash<QString, QSharedPointer<Scan>> pending;
+};
+
+#endif
@@ -28,7 +28,9 @@ MetadataResult MetadataLoader::parse(QByteArray data)
 
     // we only support 1 stream of each type at the moment
     format = root.value("format").toObject();
-    bool isAudio = false;
+    // the streams of the previously loaded file would otherwise be kept
+    video = {};
+    audio = {};
 
     for (QJsonValueRef streamRef : streams)
     {
@@ -43,7 +45,6 @@ MetadataResult MetadataLoader::parse(QByteArray data)
         if (type == "audio" && audio.isEmpty())
         {
             audio = stream;
-            isAudio = true;
         }
     }
 
@@ -68,7 +69,8 @@ MetadataResult MetadataLoader::parse(QByteArray data)
         .durationSeconds = value(errors, format, "duration", true).toDouble(),
         .aspectRatioX = aspectRatio.first,
         .aspectRatioY = aspectRatio.second,
-        .frameRate = isAudio ? 0 : getFrameRate(errors),
+        // inputs with audio still have the frame rate of their video
+        .frameRate = video.isEmpty() ? 0 : getFrameRate(errors),
         .videoCodec = value(errors, video, "codec_name", true).toString(),
         .audioCodec = value(errors, audio, "codec_name", true).toString(),
         .container = "" // TODO: Find a reliable way to query format type
@@ -137,7 +139,8 @@ double MetadataLoader::getFrameRate(QList<QString>& errors)
 {
     const QVariant frameRateData = value(errors, video, "r_frame_rate");
 
-    if (frameRateData.isNull())
+    // attached pictures and some streams report 0/0, which says no more than a missing rate
+    if (frameRateData.isNull() || frameRateData.toString().endsWith("/0"))
     {
         const QVariant nbrFramesData = value(errors, video, "nb_frames");
         const QVariant durationData = value(errors, format, "duration");
@@ -23,6 +23,8 @@ int main(int argc, char* argv[])
                                                  { return std::make_shared<IniSettings>("config.ini", "config_default.ini"); }),
         di::bind<Settings>.named(di_presets).to([]
                                                 { return std::make_shared<IniSettings>("presets.ini"); }),
+        di::bind<Settings>.named(di_history).to([]
+                                                { return std::make_shared<IniSettings>("history.ini"); }),
         di::bind<Notifier>.to<MessageBoxNotifier>(), di::bind<FormatSupportLoader>.to<FFmpegFormatSupportLoader>()
     );
 
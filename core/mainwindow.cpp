@@ -7,6 +7,7 @@
 #include <QThread>
 #include <QTimer>
 #include <QWhatsThis>
+#include <algorithm>
 #include <utility>
 
 #include "encoder/encoder_options_builder.hpp"
@@ -19,19 +20,24 @@ using std::optional;
 
 MainWindow::MainWindow(
     MediaEncoder& encoder,
+    JobScheduler& scheduler,
+    RateControlRegistry& rateControl,
     std::shared_ptr<Settings> settings,
     std::shared_ptr<Settings> presetsSettings,
     std::shared_ptr<Serializer> serializer,
     MetadataLoader& metadata,
     Notifier& notifier,
     PlatformInfo& platformInfo,
-    FormatSupportLoader& formatSupportLoader
+    FormatSupportLoader& formatSupportLoader,
+    ThumbnailGenerator& thumbnailGenerator
 )
     : ui(new Ui::MainWindow)
     , overlay(new OverlayWidget(this))
     , warnings(new Warnings(ui->warningTooltipButton))
     , menu(new QMenu(this))
     , encoder(encoder)
+    , scheduler(scheduler)
+    , rateControl(rateControl)
     , settings(settings)
     , presetsSettings(std::move(presetsSettings))
     , serializer(std::move(serializer))
@@ -39,6 +45,7 @@ MainWindow::MainWindow(
     , notifier(notifier)
     , platformInfo(platformInfo)
     , formatSupport(formatSupportLoader)
+    , thumbnailGenerator(thumbnailGenerator)
 {
     CheckForFFmpeg();
 
@@ -49,6 +56,9 @@ MainWindow::MainWindow(
     overlay->hide();
     overlay->raise();
 
+    // shown once a file is selected
+    ui->thumbnailStripLabel->hide();
+
     ui->mainHeading->setText(QApplication::applicationName());
 
     ui->audioVideoButtonGroup->setId(ui->radVideoAudio, 0);
@@ -64,6 +74,7 @@ MainWindow::MainWindow(
         ui->closeOnSuccessCheckBox,
         ui->commonFormatsOnlyCheckbox,
         ui->deleteOnSuccessCheckBox,
+        ui->followSpinBox,
         ui->inputFileLineEdit,
         ui->openExplorerOnSuccessCheckBox,
         ui->outputFileNameSuffixCheckBox,
@@ -73,7 +84,14 @@ MainWindow::MainWindow(
 
     presetWidgets = std::make_unique<const QList<QObject*>>(QList<QObject*> {
         ui->aspectRatioSpinBoxH,
+        ui->autoResolutionCheckBox,
+        ui->autoCropCheckBox,
+        ui->perTitleLadderCheckBox,
+        ui->splitPartsCheckBox,
+        ui->sceneCutsCheckBox,
         ui->aspectRatioSpinBoxV,
+        ui->decimateCheckBox,
+        ui->autoTrimCheckBox,
         ui->audioCodecComboBox,
         ui->audioQualitySlider,
         ui->containerComboBox,
@@ -83,28 +101,43 @@ MainWindow::MainWindow(
         ui->fpsSpinBox,
         ui->heightSpinBox,
         ui->speedSpinBox,
+        ui->speedTierComboBox,
+        ui->streamingFormatComboBox,
         ui->videoCodecComboBox,
+        ui->videoQualitySpinBox,
         ui->widthSpinBox,
         ui->audioChannelCountSpinbox,
+        ui->loudnessCheckBox,
+        ui->loudnessSpinBox,
     });
 
     videoControls = std::make_unique<const QList<QWidget*>>(QList<QWidget*> {
         ui->videoCodecComboBox,
+        ui->autoResolutionCheckBox,
+        ui->perTitleLadderCheckBox,
+        ui->splitPartsCheckBox,
         ui->widthSpinBox,
         ui->heightSpinBox,
+        ui->autoCropCheckBox,
         ui->aspectRatioSpinBoxH,
         ui->aspectRatioSpinBoxV,
         ui->fpsSpinBox,
+        ui->decimateCheckBox,
         ui->speedSpinBox,
+        ui->speedTierComboBox,
+        ui->videoQualitySpinBox,
     });
 
     audioControls = std::make_unique<const QList<QWidget*>>(QList<QWidget*> {
         ui->audioCodecComboBox,
         ui->audioQualitySlider,
+        ui->loudnessCheckBox,
     });
 
     SetupAnimations();
     SetupMenu();
+    SetupScheduler();
+    SetupRateControl();
     SetupEventCallbacks();
 
     QuerySupportedFormatsAsync();
@@ -140,15 +173,61 @@ void MainWindow::SetupMenu()
     ui->infoMenuToolButton->setMenu(menu.get());
 }
 
+void MainWindow::SetupScheduler() const
+{
+    const double budgetMb = settings->get("Main/dMemoryBudgetMb").toDouble();
+    const double budgetPercent = settings->get("Main/dMemoryBudgetPercent").toDouble();
+
+    // an explicit budget takes priority over a share of the memory available to us
+    scheduler.SetMemoryBudgetMb(budgetMb > 0 ? budgetMb : platformInfo.totalMemoryMb() * budgetPercent / 100);
+    scheduler.SetMaxConcurrentJobs(settings->get("Main/iMaxConcurrentJobs").toInt());
+    scheduler.SetLimitEncoderMemory(settings->get("Main/bLimitEncoderMemory").toBool());
+}
+
+void MainWindow::SetupRateControl() const
+{
+    const QString prefix = "RateControl.";
+
+    // e.g. [RateControl.libfdk_aac] with sBasedOn = aac and dOvershootPercent = 2
+    for (const QString& group : settings->groups())
+    {
+        if (!group.startsWith(prefix))
+            continue;
+
+        const auto number = [this, &group](const QString& key) -> optional<double>
+        {
+            const QVariant value = settings->get(group + "/" + key);
+            return value.isValid() ? optional(value.toDouble()) : std::nullopt;
+        };
+
+        const optional<double> overshootPercent = number("dOvershootPercent");
+
+        rateControl.Register(group.mid(prefix.size()), {
+            .basedOn = settings->get(group + "/sBasedOn").toString(),
+            .overshootFraction = overshootPercent.has_value() ? optional(*overshootPercent / 100) : std::nullopt,
+            .minBitrateKbps = number("dMinBitrateKbps"),
+            .maxBitrateKbps = number("dMaxBitrateKbps"),
+            .packetsPerSecond = number("dPacketsPerSecond"),
+        });
+    }
+}
+
 void MainWindow::SetupEventCallbacks()
 {
     connect(&formatSupport, &FormatSupportLoader::queryCompleted, this, &MainWindow::HandleFormatsQueryResult);
 
     connect(&encoder, &MediaEncoder::encodingStarted, this, &MainWindow::HandleStart);
     connect(&encoder, &MediaEncoder::encodingSucceeded, this, &MainWindow::HandleSuccess);
+    connect(&encoder, &MediaEncoder::previewEncoded, this, &MainWindow::HandlePreview);
     connect(&encoder, &MediaEncoder::encodingFailed, this, &MainWindow::HandleFailure);
+    connect(&encoder, &MediaEncoder::ladderOptimized, &encoder, &MediaEncoder::EncodeRenditions);
+    connect(&encoder, &MediaEncoder::renditionsSucceeded, this, &MainWindow::HandleRenditionsSuccess);
+    connect(&encoder, &MediaEncoder::partsSucceeded, this, &MainWindow::HandlePartsSuccess);
+    connect(&encoder, &MediaEncoder::segmentsWritten, this, &MainWindow::HandleSegmentsWritten);
+    connect(&encoder, &MediaEncoder::imagesConverted, this, &MainWindow::HandleImagesConverted);
     connect(&encoder, &MediaEncoder::encodingProgressUpdate, this, [this](int progress)
             { SetProgressShown({ .status = tr("Compressing..."), .progressPercent = progress }); });
+    connect(&encoder, &MediaEncoder::growingProgressUpdate, this, &MainWindow::HandleGrowingProgress);
 }
 
 void MainWindow::QuerySupportedFormatsAsync() const
@@ -220,7 +299,12 @@ void MainWindow::dragEnterEvent(QDragEnterEvent* event)
     isValidMimeForDrop = mimeType.name().startsWith("image/")
                       || mimeType.name().startsWith("video/")
                       || mimeType.name().startsWith("audio/");
-    if (isValidMimeForDrop)
+    if (isValidMimeForDrop && isImageBatch(event->mimeData()->urls()))
+    {
+        overlay->setBackgroundColor(QColor(0, 0, 0, 128));
+        overlay->setText(tr("Drop to convert %1 images").arg(event->mimeData()->urls().size()));
+    }
+    else if (isValidMimeForDrop)
     {
         overlay->setBackgroundColor(QColor(0, 0, 0, 128));
         overlay->setText("Drop to select file");
@@ -247,14 +331,28 @@ void MainWindow::dropEvent(QDropEvent* event)
 
     if (isValidMimeForDrop)
     {
-        const QUrl url = event->mimeData()->urls().first();
-        LoadInputFile(url);
+        const QList<QUrl> urls = event->mimeData()->urls();
+
+        if (isImageBatch(urls))
+            StartImageBatch(urls);
+        else
+            LoadInputFile(urls.first());
     }
 
     overlay->hideWithFade();
     isDragging = false;
 }
 
+bool MainWindow::isImageBatch(const QList<QUrl>& urls) const
+{
+    const QMimeDatabase database;
+
+    return urls.size() > 1 && std::all_of(urls.begin(), urls.end(), [&database](const QUrl& url)
+    {
+        return database.mimeTypeForFile(url.toLocalFile()).name().startsWith("image/");
+    });
+}
+
 void MainWindow::dragLeaveEvent(QDragLeaveEvent* event)
 {
     overlay->hideWithFade();
@@ -275,8 +373,6 @@ void MainWindow::closeEvent(QCloseEvent* event)
 
 void MainWindow::StartEncoding()
 {
-    EncoderOptionsBuilder builder;
-
     const QString inputPath = ui->inputFileLineEdit->text();
     const QString outputPath = getOutputPath(inputPath);
 
@@ -289,8 +385,81 @@ void MainWindow::StartEncoding()
     //     return;
     // }
 
-    if (metadata.has_value())
-        builder.useMetadata(*metadata);
+    const auto maybeOptions = buildOptions(inputPath, outputPath, metadata);
+    if (std::holds_alternative<QList<QString>>(maybeOptions))
+    {
+        notifier.Notify(Severity::Error, "Invalid encoding options", std::get<QList<QString>>(maybeOptions).join("\n"));
+        return;
+    }
+
+    const EncoderOptions options = std::get<EncoderOptions>(maybeOptions);
+
+    // parts are cut to the desired size, which a ladder does not use, a streaming output is a single rendition, and a
+    // growing input cannot be probed for one
+    if (ui->perTitleLadderCheckBox->isChecked() && options.videoCodec.has_value() && !options.splitIntoParts && !options.streamingFormat.has_value()
+        && !options.followIdleSeconds.has_value())
+        encoder.OptimizeLadder(options);
+    else
+        encoder.Encode(options);
+}
+
+void MainWindow::StartPreview()
+{
+    if (!metadata.has_value())
+    {
+        notifier.Notify(Severity::Info, tr("No file selected"), tr("Please select a file to continue."));
+        return;
+    }
+
+    const QString inputPath = ui->inputFileLineEdit->text();
+    const auto maybeOptions = buildOptions(inputPath, getOutputPath(inputPath), metadata);
+    if (std::holds_alternative<QList<QString>>(maybeOptions))
+    {
+        notifier.Notify(Severity::Error, "Invalid encoding options", std::get<QList<QString>>(maybeOptions).join("\n"));
+        return;
+    }
+
+    SetProgressShown({ .status = tr("Encoding preview..."), .progressPercent = 0 });
+    encoder.EncodePreview(std::get<EncoderOptions>(maybeOptions), ui->previewTimeEdit->time().msecsSinceStartOfDay() / 1000.0);
+}
+
+void MainWindow::StartImageBatch(const QList<QUrl>& urls)
+{
+    const bool hasFixedFileName = !ui->outputFileNameSuffixCheckBox->isChecked() && !ui->outputFileNameLineEdit->text().isEmpty();
+    std::vector<EncoderOptions> images;
+
+    for (const QUrl& url : urls)
+    {
+        const QString inputPath = url.toLocalFile();
+        QString outputPath = getOutputPath(inputPath);
+
+        // a fixed file name would have every image overwrite the previous one
+        if (hasFixedFileName)
+        {
+            const QFileInfo output(outputPath);
+            outputPath = output.dir().filePath(QFileInfo(inputPath).completeBaseName() + "_" + output.fileName());
+        }
+
+        // images are converted without probing them first, so there is no metadata to go with them
+        const auto maybeOptions = buildOptions(inputPath, outputPath, Metadata {});
+        if (std::holds_alternative<QList<QString>>(maybeOptions))
+        {
+            notifier.Notify(Severity::Error, "Invalid encoding options", std::get<QList<QString>>(maybeOptions).join("\n"));
+            return;
+        }
+
+        images.push_back(std::get<EncoderOptions>(maybeOptions));
+    }
+
+    encoder.ConvertImages(images);
+}
+
+std::variant<EncoderOptions, QList<QString>> MainWindow::buildOptions(const QString& inputPath, const QString& outputPath, const optional<Metadata>& inputMetadata) const
+{
+    EncoderOptionsBuilder builder;
+
+    if (inputMetadata.has_value())
+        builder.useMetadata(*inputMetadata);
 
     const auto streamType = static_cast<StreamType>(ui->audioVideoButtonGroup->checkedId());
     const bool hasVideo = streamType == VideoAudio || streamType == VideoOnly;
@@ -302,12 +471,30 @@ void MainWindow::StartEncoding()
     if (hasAudio)
         builder.withAudioCodec(ui->audioCodecComboBox->currentData().value<Codec>());
 
+    // first item keeps the codec's own defaults
+    if (const int speedTierIndex = ui->speedTierComboBox->currentIndex(); speedTierIndex > 0)
+        builder.atSpeedTier(static_cast<SpeedTier>(speedTierIndex - 1));
+
+    // first item writes a single file
+    if (const int streamingFormatIndex = ui->streamingFormatComboBox->currentIndex(); streamingFormatIndex > 0)
+        builder.withStreamingFormat(static_cast<StreamingFormat>(streamingFormatIndex - 1));
+
     builder.inputFrom(inputPath)
         .outputTo(outputPath)
         .withContainer(ui->containerComboBox->currentData().value<Container>())
         .withTargetOutputSize(getOutputSizeKbps())
+        .withConstantQuality(ui->videoQualitySpinBox->value())
+        .withAutoResolution(ui->autoResolutionCheckBox->isChecked())
+        .withAutoCrop(ui->autoCropCheckBox->isChecked())
+        .withDecimation(ui->decimateCheckBox->isChecked())
+        .withAutoTrim(ui->autoTrimCheckBox->isChecked())
+        .withSplitIntoParts(ui->splitPartsCheckBox->isChecked())
+        .withSceneCutSnapping(isSplitAtSceneCuts())
+        .withTrim(ui->trimStartTimeEdit->time().msecsSinceStartOfDay() / 1000.0, ui->trimEndTimeEdit->time().msecsSinceStartOfDay() / 1000.0)
+        .followUntilIdle(ui->followSpinBox->value())
         .withAudioQuality(ui->audioQualitySlider->value() / 100.0)
         .withAudioChannelsCount(ui->audioChannelCountSpinbox->value())
+        .withLoudnessTarget(isLoudnessNormalized() ? ui->loudnessSpinBox->value() : 0)
         .withOutputWidth(ui->widthSpinBox->value())
         .withOutputHeight(ui->heightSpinBox->value())
         .withAspectRatio(QPoint(ui->aspectRatioSpinBoxH->value(), ui->aspectRatioSpinBoxV->value()))
@@ -318,15 +505,7 @@ void MainWindow::StartEncoding()
         .withMinAudioBitrate(settings->get("Main/dMinBitrateAudioKbps").toDouble())
         .withMaxAudioBitrate(settings->get("Main/dMaxBitrateAudioKbps").toDouble());
 
-    const auto maybeOptions = builder.build();
-    if (std::holds_alternative<QList<QString>>(maybeOptions))
-    {
-        notifier.Notify(Severity::Error, "Invalid encoding options", std::get<QList<QString>>(maybeOptions).join("\n"));
-        return;
-    }
-
-    const EncoderOptions options = std::get<EncoderOptions>(maybeOptions);
-    encoder.Encode(options);
+    return builder.build();
 }
 
 void MainWindow::HandleStart(double videoBitrateKbps, double audioBitrateKbps) const
@@ -343,18 +522,26 @@ void MainWindow::HandleSuccess(
     const EncoderOptions& options, const MediaEncoder::ComputedOptions& computed, QFile& output
 ) const
 {
-    SetProgressShown({ .status = tr("Compression complete"), .progressPercent = 100 });
-
     QString summary;
     QString videoBitrate = computed.videoBitrateKbps.has_value() ? QString::number(*computed.videoBitrateKbps) + "kbps"
                                                                  : "auto-set bitrate";
+    if (options.constantQualityPercent.has_value())
+        videoBitrate = tr("constant quality %1%").arg(*options.constantQualityPercent);
 
     if (options.videoCodec.has_value())
     {
         summary += tr("Using video codec %1 at %2 with container %3.\n")
                        .arg(options.videoCodec->displayName, videoBitrate, options.container.displayName);
     }
-    if (options.audioCodec.has_value())
+    if (computed.outputHeight.has_value() || computed.fps.has_value())
+    {
+        const Metadata& input = options.inputMetadata;
+        summary += tr("Lowered to %1x%2 at %3 fps to fit the requested size.\n")
+                       .arg(QString::number(computed.outputWidth.value_or(input.width)), QString::number(computed.outputHeight.value_or(input.height)),
+                            QString::number(computed.fps.value_or(input.frameRate)));
+    }
+    // images converted in-process ignore the audio codec and compute no bitrates
+    if (options.audioCodec.has_value() && computed.audioBitrateKbps.has_value())
     {
         summary += tr("Using audio codec %1 at %2kbps.\n")
                        .arg(options.audioCodec->displayName, QString::number(*computed.audioBitrateKbps));
@@ -363,25 +550,30 @@ void MainWindow::HandleSuccess(
     {
         summary += tr("Requested size was %1 kb.\nActual "
                       "compression achieved is %2 kb.")
-                       .arg(QString::number(*options.sizeKbps), QString::number(output.size() / 125.0));
+                       .arg(QString::number(*options.sizeKbps), QString::number(MediaEncoder::outputSizeKb(options, output.fileName())));
     }
 
-    notifier.Notify(Severity::Info, tr("Compressed successfully"), summary);
+    FinishSuccess(options.inputPath, QFileInfo(output).absoluteFilePath(), summary);
+}
 
+void MainWindow::FinishSuccess(const QString& inputPath, const QString& outputPath, const QString& summary) const
+{
+    SetProgressShown({ .status = tr("Compression complete"), .progressPercent = 100 });
+    notifier.Notify(Severity::Info, tr("Compressed successfully"), summary);
     SetProgressShown({});
 
-    const QFileInfo fileInfo(output);
+    const QFileInfo fileInfo(outputPath);
     QString command = platformInfo.isWindows() ? "explorer" : "xdg-open";
 
     if (ui->deleteOnSuccessCheckBox->isChecked())
     {
-        QFile input(options.inputPath);
+        QFile input(inputPath);
         input.open(QIODevice::WriteOnly);
 
         if (!(input.remove()))
         {
             notifier.Notify(
-                Severity::Error, tr("Failed to remove input file"), output.errorString() + "\n\n" + options.inputPath
+                Severity::Error, tr("Failed to remove input file"), input.errorString() + "\n\n" + inputPath
             );
         }
         else
@@ -408,6 +600,92 @@ void MainWindow::HandleSuccess(
     }
 }
 
+void MainWindow::HandleGrowingProgress(double encodedSeconds, double writtenSeconds) const
+{
+    const auto timeOf = [](double seconds) { return QTime(0, 0).addSecs(qRound(seconds)).toString("H:mm:ss"); };
+
+    // the bar cannot fill up until the input stops growing
+    const optional<int> progressPercent = writtenSeconds > 0 ? optional<int>(qMin(99, qRound(encodedSeconds * 100 / writtenSeconds))) : optional<int>();
+    SetProgressShown({ .status = tr("Following the input..."), .progressPercent = progressPercent });
+
+    ui->progressBarLabel->setText(writtenSeconds > 0 ? tr("Encoded %1 of about %2 written so far").arg(timeOf(encodedSeconds), timeOf(writtenSeconds))
+                                                     : tr("Encoded %1 so far").arg(timeOf(encodedSeconds)));
+}
+
+void MainWindow::HandleSegmentsWritten(const QString& playlistPath, qsizetype count) const
+{
+    ui->progressBarLabel->setText(tr("Segments ready in %1: %2").arg(QFileInfo(playlistPath).fileName(), QString::number(count)));
+}
+
+void MainWindow::HandlePreview(const QString& outputPath, double projectedSizeKbps, double projectedSeconds) const
+{
+    SetProgressShown({});
+
+    QString summary = tr("With these settings, the output would be about %1 kb and take about %2 to encode.")
+                          .arg(QString::number(qRound(projectedSizeKbps)), QTime(0, 0).addSecs(qRound(projectedSeconds)).toString("H:mm:ss"));
+
+    if (const double requestedKbps = getOutputSizeKbps(); requestedKbps > 0)
+        summary += " " + tr("That is %1% of the requested size.").arg(qRound(projectedSizeKbps * 100 / requestedKbps));
+
+    notifier.Notify(Severity::Info, tr("Preview encoded"), summary);
+
+    const QString command = platformInfo.isWindows() ? "explorer" : "xdg-open";
+    QProcess::execute(QString(R"(%1 "%2")").arg(command, outputPath));
+}
+
+void MainWindow::HandleRenditionsSuccess(const QString& inputPath, const QStringList& outputPaths) const
+{
+    FinishSuccess(inputPath, outputPaths.value(0), tr("Encoded %1 renditions:\n%2").arg(outputPaths.size()).arg(outputsSummary(outputPaths)));
+}
+
+void MainWindow::HandlePartsSuccess(const QString& inputPath, const QStringList& outputPaths) const
+{
+    FinishSuccess(inputPath, outputPaths.value(0), tr("Split into %1 parts:\n%2").arg(outputPaths.size()).arg(outputsSummary(outputPaths)));
+}
+
+QString MainWindow::outputsSummary(const QStringList& outputPaths)
+{
+    QStringList summary;
+    for (const QString& path : outputPaths)
+        summary.append(tr("%1 (%2 kb)").arg(QFileInfo(path).fileName(), QString::number(QFileInfo(path).size() / 125.0)));
+
+    return summary.join("\n");
+}
+
+void MainWindow::HandleImagesConverted(const QList<ImageConverter::Result>& results) const
+{
+    SetProgressShown({ .status = tr("Conversion complete"), .progressPercent = 100 });
+
+    QStringList errors;
+    qsizetype duplicates = 0;
+    double totalKbps = 0;
+
+    for (const ImageConverter::Result& result : results)
+    {
+        if (!result.duplicateOf.isEmpty())
+            duplicates++;
+        else if (result.error.isEmpty())
+            totalKbps += result.sizeKbps;
+        else
+            errors.append(QString("%1: %2").arg(QFileInfo(result.outputPath).fileName(), result.error));
+    }
+
+    QString summary = tr("Converted %1 of %2 images, %3 kb in total.")
+                          .arg(results.size() - duplicates - errors.size())
+                          .arg(results.size() - duplicates)
+                          .arg(QString::number(qRound(totalKbps)));
+
+    if (duplicates > 0)
+        summary += " " + tr("Skipped %1 copies of images already in the batch.").arg(duplicates);
+
+    if (errors.isEmpty())
+        notifier.Notify(Severity::Info, tr("Converted successfully"), summary);
+    else
+        notifier.Notify(Severity::Warning, tr("Some images could not be converted"), summary, errors.join("\n"));
+
+    SetProgressShown({});
+}
+
 void MainWindow::HandleFailure(const QString& shortError, const QString& longError) const
 {
     notifier.Notify(Severity::Warning, tr("Compression failed"), shortError, longError);
@@ -632,6 +910,19 @@ void MainWindow::UpdateControlsState() const
 
     for (QWidget* control : *audioControls)
         control->setEnabled((isVideoAudio || isAudioOnly) && (!isAudioPassthrough || control == ui->audioCodecComboBox));
+
+    ui->loudnessSpinBox->setEnabled(isLoudnessNormalized());
+    ui->sceneCutsCheckBox->setEnabled(ui->splitPartsCheckBox->isEnabled() && ui->splitPartsCheckBox->isChecked());
+}
+
+bool MainWindow::isLoudnessNormalized() const
+{
+    return ui->loudnessCheckBox->isEnabled() && ui->loudnessCheckBox->isChecked();
+}
+
+bool MainWindow::isSplitAtSceneCuts() const
+{
+    return ui->sceneCutsCheckBox->isEnabled() && ui->sceneCutsCheckBox->isChecked();
 }
 
 void MainWindow::ShowMetadata()
@@ -710,10 +1001,50 @@ void MainWindow::ReceiveMediaMetadata(MetadataResult result)
 
         notifier.Notify(error);
         ui->inputFileLineEdit->clear();
+        ui->thumbnailStripLabel->hide();
         return;
     }
 
     metadata = std::get<Metadata>(result);
+
+    const QString inputPath = ui->inputFileLineEdit->text();
+    thumbnailGenerator.Generate(inputPath, *metadata).then(this, [this, inputPath](const QImage& strip)
+    {
+        ShowThumbnails(inputPath, strip);
+    });
+
+    // trims and previews only make sense for the input they were chosen for
+    const double lastMsecs = QTime(23, 59, 59, 999).msecsSinceStartOfDay();
+    const QTime end = QTime::fromMSecsSinceStartOfDay(static_cast<int>(qMin(metadata->durationSeconds * 1000, lastMsecs)));
+    for (QTimeEdit* timeEdit : { ui->trimStartTimeEdit, ui->trimEndTimeEdit, ui->previewTimeEdit })
+    {
+        timeEdit->setMaximumTime(end);
+        timeEdit->setTime(QTime(0, 0));
+    }
+
+    // measuring while the options are being chosen saves waiting for it once the encode starts
+    if (isLoudnessNormalized() && !metadata->audioCodec.isEmpty())
+        encoder.MeasureLoudnessAhead(inputPath);
+
+    if (!metadata->videoCodec.isEmpty())
+        encoder.IndexKeyframesAhead(inputPath);
+}
+
+void MainWindow::ShowThumbnails(const QString& path, const QImage& strip) const
+{
+    // another file may have been selected while the thumbnails of this one were decoded
+    if (ui->inputFileLineEdit->text() != path)
+        return;
+
+    if (strip.isNull())
+    {
+        ui->thumbnailStripLabel->hide();
+        return;
+    }
+
+    const int width = qMin(strip.width(), ui->gridLayout->geometry().width());
+    ui->thumbnailStripLabel->setPixmap(QPixmap::fromImage(strip.scaledToWidth(width, Qt::SmoothTransformation)));
+    ui->thumbnailStripLabel->show();
 }
 
 QString MainWindow::getOutputPath(QString inputFilePath) const
@@ -2,6 +2,7 @@
 
 #include "core/formats/metadata_loader.hpp"
 #include "encoder/encoder.hpp"
+#include "encoder/thumbnail_generator.hpp"
 #include "formats/format_support_loader.hpp"
 #include "notifier/notifier.hpp"
 #include "settings/serializer.hpp"
@@ -35,13 +36,16 @@ public:
     BOOST_DI_INJECT(
         MainWindow,
         MediaEncoder& encoder,
+        JobScheduler& scheduler,
+        RateControlRegistry& rateControl,
         (named = di_settings) std::shared_ptr<Settings> settings,
         (named = di_presets) std::shared_ptr<Settings> presetsSettings,
         std::shared_ptr<Serializer> serializer,
         MetadataLoader& metadata,
         Notifier& notifier,
         PlatformInfo& platformInfo,
-        FormatSupportLoader& formatSupportLoader
+        FormatSupportLoader& formatSupportLoader,
+        ThumbnailGenerator& thumbnailGenerator
     );
     ~MainWindow() override;
 
@@ -55,6 +59,8 @@ public:
 protected:
     void CheckForFFmpeg() const;
     void SetupMenu();
+    void SetupScheduler() const;
+    void SetupRateControl() const;
     void SetupEventCallbacks();
     void QuerySupportedFormatsAsync() const;
 
@@ -70,12 +76,24 @@ protected:
 
     void HandleStart(double videoBitrateKbps, double audioBitrateKbps) const;
     void HandleSuccess(const EncoderOptions& options, const MediaEncoder::ComputedOptions& computed, QFile& output) const;
+    void HandlePreview(const QString& outputPath, double projectedSizeKbps, double projectedSeconds) const;
+    void HandleRenditionsSuccess(const QString& inputPath, const QStringList& outputPaths) const;
+    void HandlePartsSuccess(const QString& inputPath, const QStringList& outputPaths) const;
+    //! Reports an encoded input with the summary, then carries out what the user asked for: deleting the input,
+    //! showing and playing the output, and closing. Outputs split over several files are shown and played from the
+    //! first one.
+    void FinishSuccess(const QString& inputPath, const QString& outputPath, const QString& summary) const;
+    [[nodiscard]] static QString outputsSummary(const QStringList& outputPaths);
+    void HandleGrowingProgress(double encodedSeconds, double writtenSeconds) const;
+    void HandleSegmentsWritten(const QString& playlistPath, qsizetype count) const;
+    void HandleImagesConverted(const QList<ImageConverter::Result>& results) const;
     void HandleFailure(const QString& shortError, const QString& longError) const;
     void ShowAbout() const;
 
     // NOTE: const parameters are NOT supported by Qt slots setup from the designer!
 private slots:
     void StartEncoding();
+    void StartPreview();
     void SetAdvancedMode(bool enabled) const;
     void OpenInputFile();
     void SelectOutputDirectory();
@@ -100,8 +118,14 @@ private:
 
     void QueryMediaMetadataAsync(const QString& path);
     void ReceiveMediaMetadata(MetadataResult result);
+    void ShowThumbnails(const QString& path, const QImage& strip) const;
     QString getOutputPath(QString inputFilePath) const;
+    std::variant<EncoderOptions, QList<QString>> buildOptions(const QString& inputPath, const QString& outputPath, const optional<Metadata>& inputMetadata) const;
+    void StartImageBatch(const QList<QUrl>& urls);
+    bool isImageBatch(const QList<QUrl>& urls) const;
     inline bool isAutoValue(QAbstractSpinBox* spinBox) const;
+    bool isLoudnessNormalized() const;
+    bool isSplitAtSceneCuts() const;
     void SetProgressShown(const ProgressState& state) const;
     void LoadSelectedUrl();
     void LoadInputFile(const QUrl& url);
@@ -130,6 +154,8 @@ private:
     QScopedPointer<QMenu> menu;
 
     MediaEncoder& encoder;
+    JobScheduler& scheduler;
+    RateControlRegistry& rateControl;
     std::shared_ptr<Settings> settings;
     std::shared_ptr<Settings> presetsSettings;
     std::shared_ptr<Serializer> serializer;
@@ -137,6 +163,7 @@ private:
     Notifier& notifier;
     PlatformInfo& platformInfo;
     FormatSupportLoader& formatSupport;
+    ThumbnailGenerator& thumbnailGenerator;
 
     bool isDragging = false;
     bool isValidMimeForDrop = false;
@@ -2,6 +2,9 @@
 
 #include <QVariant>
 
+//! Settings that record what was learned from past jobs, as opposed to what the user chose.
+inline auto di_history = [] {};
+
 struct Settings {
     virtual ~Settings() = default;
 
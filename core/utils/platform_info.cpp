@@ -1,11 +1,21 @@
 #include "platform_info.hpp"
 
+#include <QFile>
 #include <QOffscreenSurface>
 #include <QOpenGLFunctions>
 #include <QProcess>
+#include <QRegularExpression>
 #include <QString>
 
-PlatformInfo::PlatformInfo() { m_isNvidia = DetectNvidia(); }
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+PlatformInfo::PlatformInfo()
+{
+    m_isNvidia = DetectNvidia();
+    m_totalMemoryMb = DetectTotalMemoryMb();
+}
 
 bool PlatformInfo::DetectNvidia() const
 {
@@ -26,3 +36,38 @@ bool PlatformInfo::DetectNvidia() const
 
     return vendorString.contains("NVIDIA", Qt::CaseInsensitive);
 }
+
+double PlatformInfo::DetectTotalMemoryMb() const
+{
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys / (1024.0 * 1024.0) : 0;
+#else
+    double totalMb = 0;
+
+    QFile memInfo("/proc/meminfo");
+    if (memInfo.open(QIODevice::ReadOnly))
+    {
+        static const QRegularExpression regex(R"(MemTotal:\s+(\d+) kB)");
+        const QRegularExpressionMatch match = regex.match(memInfo.readAll());
+
+        if (match.hasMatch())
+            totalMb = match.captured(1).toDouble() / 1024;
+    }
+
+    // containers are usually limited by their cgroup rather than by the host's memory
+    QFile cgroupLimit("/sys/fs/cgroup/memory.max");
+    if (cgroupLimit.open(QIODevice::ReadOnly))
+    {
+        bool isNumber = false;
+        const double limitMb = cgroupLimit.readAll().trimmed().toDouble(&isNumber) / (1024 * 1024);
+
+        if (isNumber && limitMb > 0 && (totalMb <= 0 || limitMb < totalMb))
+            totalMb = limitMb;
+    }
+
+    return totalMb;
+#endif
+}
@@ -11,12 +11,15 @@ public:
 
     bool isWindows() const { return m_isWindows; };
     bool isNvidia() const { return m_isNvidia; };
+    double totalMemoryMb() const { return m_totalMemoryMb; };
 
 private:
     bool DetectNvidia() const;
+    double DetectTotalMemoryMb() const;
 
     const bool m_isWindows = QSysInfo::kernelType() == "winnt";
     bool m_isNvidia;
+    double m_totalMemoryMb;
 };
 
 #endif